@@ -29,7 +29,24 @@ MAX_OUT_NB = 24
 MAX_IN_NB = 12
 SLOT_DESC_SIZE = 50
 IO_NAME_LEN = 20
-FLASH_SLOT_NB = 16
+FLASH_SLOT_NB = 8
+OUTPUT_LUT_POINT_NB = 9
+FRAME_QUEUE_SIZE = 8
+CORE_STAGE_MAX_NB = 8
+PCCOM_MASTER_PACKET_FLAG = 0x80
+
+(
+    SYS_CONF_SECTION_INPUT,
+    SYS_CONF_SECTION_OUTPUT,
+    SYS_CONF_SECTION_ACTIVE_BM,
+    SYS_CONF_SECTION_OUTPUT_LUT,
+    SYS_CONF_SECTION_NB,
+) = range(5)
+
+(
+    OVERRUN_CATCH_UP,
+    OVERRUN_SKIP,
+) = range(2)
 
 (
     MODE_NORMAL,
@@ -37,6 +54,24 @@ FLASH_SLOT_NB = 16
     MODE_INPUT_CALIB,
 ) = range(3)
 
+(
+    FRAME_INTERP_LINEAR,
+    FRAME_INTERP_CUBIC,
+) = range(2)
+
+GAIT_LEG_NB = 6
+
+(
+    GAIT_TRIPOD,
+    GAIT_RIPPLE,
+    GAIT_WAVE,
+) = range(3)
+
+(
+    SCB_NOTIFY_FRAME_DONE,
+    SCB_NOTIFY_GOAL_REACHED,
+) = range(2)
+
 
 class scb_msg_header(BigEndianStructure):
     _fields_ = [("module", c_uint8),
@@ -64,15 +99,129 @@ class calib_output(BigEndianStructure):
                 ("angle_180", c_short),
                 ("subtrim", c_short)]
 
+class input_stream_sample(Structure):
+    _fields_ = [("cycle", c_uint16),
+                ("active_bm", c_uint16),
+                ("raw", c_short * MAX_IN_NB)]
+
+class frame_done_notification(Structure):
+    _fields_ = [("done", c_uint8),
+                ("free", c_uint8),
+                ("idle", c_uint8)]
+
+class goal_reached_notification(Structure):
+    _pack_ = 1
+    _fields_ = [("reached_bm", c_uint32),
+                ("moving_bm", c_uint32)]
+
+class scb_notification(Structure):
+    _fields_ = [("type", c_uint8),
+                ("frame", frame_done_notification),
+                ("goal", goal_reached_notification)]
+
+class scb_clock(Structure):
+    _fields_ = [("ref_host", c_double),
+                ("offset", c_double),
+                ("drift", c_double),
+                ("rtt", c_double),
+                ("sync_nb", c_uint32),
+                ("sum_t", c_double),
+                ("sum_o", c_double),
+                ("sum_tt", c_double),
+                ("sum_to", c_double)]
+
+class output_lut(BigEndianStructure):
+    _fields_ = [("enabled", c_uint8),
+                ("reserved", c_uint8),
+                ("point", c_short * OUTPUT_LUT_POINT_NB)]
+
 class calib_raw(BigEndianStructure):
     _fields_ = [("value", c_short)]
 
 class slot_header(BigEndianStructure):
     _fields_ = [("type", c_uint32),
                 ("desc", c_char * SLOT_DESC_SIZE),
+                ("crc", c_uint16),
                 ("size", c_uint32)]
 
 
+class pid_conf(BigEndianStructure):
+    _fields_ = [("kp", c_short),
+                ("ki", c_short),
+                ("kd", c_short),
+                ("i_limit", c_short),
+                ("gain_shift", c_uint8),
+                ("feedback", c_uint8)]
+
+class gait_leg(BigEndianStructure):
+    _fields_ = [("coxa", c_uint8),
+                ("femur", c_uint8),
+                ("tibia", c_uint8),
+                ("side", c_int8),
+                ("coxa_center", c_short),
+                ("femur_ground", c_short),
+                ("tibia_ground", c_short)]
+
+class gait_conf(BigEndianStructure):
+    _fields_ = [("period", c_uint16),
+                ("stride", c_short),
+                ("lift", c_short),
+                ("tuck", c_short)]
+
+
+class input_conf(BigEndianStructure):
+    _fields_ = [("calib", calib_input),
+                ("name", c_char * IO_NAME_LEN),
+                ("mapping", c_uint8),
+                ("reserved", c_uint8)]
+
+class output_conf(BigEndianStructure):
+    _fields_ = [("calib", calib_output),
+                ("name", c_char * IO_NAME_LEN),
+                ("max_speed", c_uint16),
+                ("max_accel", c_uint16),
+                ("max_jerk", c_uint32)]
+
+SYS_CONF_IMAGE_VERSION = 3
+
+class sys_conf_image(BigEndianStructure):
+    _fields_ = [("version", c_uint16),
+                ("input_nb", c_uint8),
+                ("output_nb", c_uint8),
+                ("servo_active_bm", c_uint32),
+                ("in_conf", input_conf * MAX_IN_NB),
+                ("out_conf", output_conf * MAX_OUT_NB),
+                ("out_lut", output_lut * MAX_OUT_NB)]
+
+
+class sys_conf_digest(Structure):
+    _fields_ = [("all", c_uint16),
+                ("section", c_uint16 * SYS_CONF_SECTION_NB)]
+
+
+class latency_stats(Structure):
+    _fields_ = [("sample_nb", c_uint32),
+                ("min_us", c_uint32),
+                ("avg_us", c_uint32),
+                ("max_us", c_uint32)]
+
+
+class core_timing_stats(Structure):
+    _fields_ = [("cycle_nb", c_uint32),
+                ("missed_nb", c_uint32),
+                ("overrun_nb", c_uint32),
+                ("max_cycle_us", c_uint32),
+                ("max_late_ms", c_uint32)]
+
+class core_stage_stats(Structure):
+    _fields_ = [("period_ms", c_uint32),
+                ("run_nb", c_uint32),
+                ("missed_nb", c_uint32),
+                ("overrun_nb", c_uint32),
+                ("max_run_us", c_uint32),
+                ("max_late_ms", c_uint32)]
+
+
 class seq_frame(BigEndianStructure):
     _fields_ = [("duration", c_uint32),
                 ("active_bm", c_uint32),
@@ -101,6 +250,56 @@ class OuputCalib():
         return "%d, %d, %d, %d" % (self.min, self.max, self.angle_180,
                                    self.subtrim)
 
+class OutputLut():
+    """points are the raw values for -1.0, -0.75, ... 1.0"""
+    def __init__(self, enabled, points):
+        self.enabled = enabled
+        self.points = points
+
+    def __str__(self):
+        return "%d, %s" % (self.enabled, self.points)
+
+class PidConf():
+    def __init__(self, kp, ki, kd, i_limit, gain_shift, feedback):
+        self.kp = kp
+        self.ki = ki
+        self.kd = kd
+        self.i_limit = i_limit
+        self.gain_shift = gain_shift
+        self.feedback = feedback
+
+    def __str__(self):
+        return "%d, %d, %d, %d, %d, %d" % (self.kp, self.ki, self.kd,
+                                           self.i_limit, self.gain_shift,
+                                           self.feedback)
+
+class GaitConf():
+    """period in ms, stride, lift and tuck are raw dsp16 values"""
+    def __init__(self, period, stride, lift, tuck):
+        self.period = period
+        self.stride = stride
+        self.lift = lift
+        self.tuck = tuck
+
+    def __str__(self):
+        return "%d, %d, %d, %d" % (self.period, self.stride, self.lift, self.tuck)
+
+class GaitLeg():
+    """positions are raw dsp16 values, side is 1 or -1"""
+    def __init__(self, coxa, femur, tibia, side, coxa_center, femur_ground, tibia_ground):
+        self.coxa = coxa
+        self.femur = femur
+        self.tibia = tibia
+        self.side = side
+        self.coxa_center = coxa_center
+        self.femur_ground = femur_ground
+        self.tibia_ground = tibia_ground
+
+    def __str__(self):
+        return "%d, %d, %d, %d, %d, %d, %d" % (self.coxa, self.femur, self.tibia,
+                                               self.side, self.coxa_center,
+                                               self.femur_ground, self.tibia_ground)
+
 class InputCalib():
     def __init__(self, min, mid, max):
         self.min = min
@@ -143,6 +342,14 @@ class OpenSCBBoard():
         self._dev = None
         self._output_nb = None
         self._input_nb = None
+        self._seq_slot = None
+        self._seq_frames = []
+
+        self._lib.scb_host_time_ms.restype = c_double
+        self._lib.scb_clock_host_to_board.restype = c_uint32
+        self._lib.scb_compare_sys_conf_digest.restype = c_uint32
+        self._clock = scb_clock()
+        self._lib.scb_clock_init(byref(self._clock))
 
 
     def get_debug_message(self, timeout=100):
@@ -152,6 +359,9 @@ class OpenSCBBoard():
         if self.is_connected():
             c_msg = create_string_buffer(64)
             self._lib.scb_get_debug_message(self._dev, c_msg, 64, timeout)
+            #packets sent on the same endpoint (input stream...) are not text
+            if ord(c_msg.raw[0]) & PCCOM_MASTER_PACKET_FLAG:
+                return ""
             return c_msg.value
         return ""
 
@@ -262,7 +472,13 @@ class OpenSCBBoard():
         return self._get_out_array(c_float, self._lib.scb_get_output_goal)
 
     def get_output_speed(self):
-        return self._get_out_array(c_ubyte, self._lib.scb_get_output_speed)
+        return self._get_out_array(c_ushort, self._lib.scb_get_output_speed)
+
+    def get_output_accel(self):
+        return self._get_out_array(c_ushort, self._lib.scb_get_output_accel)
+
+    def get_output_jerk(self):
+        return self._get_out_array(c_uint, self._lib.scb_get_output_jerk)
 
     def get_output_names(self):
         c_names = self._get_out_array(c_char * IO_NAME_LEN, self._lib.scb_get_output_name)
@@ -287,7 +503,13 @@ class OpenSCBBoard():
         self._set_out_array(c_float, outputs, self._lib.scb_set_output_goal)
 
     def set_output_speed(self, speeds):
-        self._set_out_array(c_ubyte, speeds, self._lib.scb_set_out_speed)
+        self._set_out_array(c_ushort, speeds, self._lib.scb_set_out_speed)
+
+    def set_output_accel(self, accel):
+        self._set_out_array(c_ushort, accel, self._lib.scb_set_out_accel)
+
+    def set_output_jerk(self, jerk):
+        self._set_out_array(c_uint, jerk, self._lib.scb_set_out_jerk)
 
     def set_out_controlled(self, controlled):
         self._set_out_array(c_bool, controlled, self._lib.scb_set_out_controlled)
@@ -306,6 +528,55 @@ class OpenSCBBoard():
             res = self._lib.scb_save_sys_conf(self._dev)
             self._check_return_code(res)
 
+    def load_sys_conf(self):
+        if self.is_connected():
+            res = self._lib.scb_load_sys_conf(self._dev)
+            self._check_return_code(res)
+
+    def get_sys_conf_digest(self):
+        """return (digest of whole configuration, [digest of each section])"""
+        if self.is_connected():
+            digest = sys_conf_digest()
+            res = self._lib.scb_get_sys_conf_digest(self._dev, byref(digest))
+            self._check_return_code(res)
+            return (digest.all, [s for s in digest.section])
+
+    def compute_sys_conf_digest(self, image):
+        """return (digest of whole configuration, [digest of each section]) of a sys_conf_image"""
+        digest = sys_conf_digest()
+        #digest is computed on the board format of the bitmask
+        active_bm = c_uint32.from_buffer_copy(image, sys_conf_image.servo_active_bm.offset)
+        self._lib.scb_compute_sys_conf_digest(image.in_conf, image.out_conf,
+                                              image.out_lut, active_bm, byref(digest))
+        return (digest.all, [s for s in digest.section])
+
+    def compare_sys_conf_digest(self, a, b):
+        """return the bitmask of sections (1 << SYS_CONF_SECTION_xxx) that differ
+        between two digests returned by get/compute_sys_conf_digest"""
+        da = sys_conf_digest(a[0], (c_uint16 * SYS_CONF_SECTION_NB)(*a[1]))
+        db = sys_conf_digest(b[0], (c_uint16 * SYS_CONF_SECTION_NB)(*b[1]))
+        return self._lib.scb_compare_sys_conf_digest(byref(da), byref(db))
+
+    def get_sys_conf_diff(self, image):
+        """return the bitmask of sections of a sys_conf_image that differ from the board"""
+        if self.is_connected():
+            return self.compare_sys_conf_digest(self.get_sys_conf_digest(),
+                                                self.compute_sys_conf_digest(image))
+
+    def get_sys_conf(self):
+        """return the whole configuration as a sys_conf_image structure"""
+        if self.is_connected():
+            image = sys_conf_image()
+            res = self._lib.scb_get_sys_conf(self._dev, byref(image))
+            self._check_return_code(res)
+            return image
+
+    def set_sys_conf(self, image):
+        if self.is_connected():
+            image.version = SYS_CONF_IMAGE_VERSION
+            res = self._lib.scb_set_sys_conf(self._dev, byref(image))
+            self._check_return_code(res)
+
     def in_calib_set_center(self):
         if self.is_connected():
             res = self._lib.scb_in_calib_set_center(self._dev)
@@ -339,6 +610,25 @@ class OpenSCBBoard():
             res = self._lib.scb_set_out_calib_values(self._dev, cal, nb)
             self._check_return_code(res)
 
+    def get_out_lut(self):
+        if self.is_connected():
+            nb = self.get_output_nb()
+            lut = (output_lut * nb)()
+            res = self._lib.scb_get_out_lut(self._dev, lut, c_ubyte(nb))
+            self._check_return_code(res)
+            return [OutputLut(bool(l.enabled), [p for p in l.point]) for l in lut]
+
+    def set_out_lut(self, luts):
+        if self.is_connected():
+            nb = c_ubyte(len(luts))
+            lut = (output_lut * nb.value)()
+            for l, d in zip(lut, luts):
+                l.enabled = d.enabled
+                for i, p in enumerate(d.points):
+                    l.point[i] = p
+            res = self._lib.scb_set_out_lut(self._dev, lut, nb)
+            self._check_return_code(res)
+
     def set_out_calib_raw(self, no, value):
         if self.is_connected():
             c_no = c_ubyte(no)
@@ -346,6 +636,24 @@ class OpenSCBBoard():
             res = self._lib.scb_set_out_calib_raw(self._dev, c_no, c_val)
             self._check_return_code(res)
 
+    def set_input_stream(self, enable):
+        if self.is_connected():
+            res = self._lib.scb_set_input_stream(self._dev, c_bool(enable))
+            self._check_return_code(res)
+
+    def get_input_stream_sample(self, timeout=100):
+        """return (cycle, [active], [raw value]) or None if no sample was read,
+        this consumes debug messages"""
+        if self.is_connected():
+            sample = input_stream_sample()
+            res = self._lib.scb_get_input_stream_sample(self._dev, byref(sample), timeout)
+            if res <= 0:
+                return None
+            nb = self.get_input_nb()
+            return (sample.cycle,
+                    [bool(sample.active_bm & (1 << i)) for i in range(nb)],
+                    [sample.raw[i] for i in range(nb)])
+
     def _load_frame(self, duration, pos_dic):
         """pos_dic = {0: 0.3, 5: 0.4, 12: -0.8}"""
         act = []
@@ -377,24 +685,31 @@ class OpenSCBBoard():
             res = self._lib.scb_play_sequence_slot(self._dev, c_id)
             self._check_return_code(res)
 
-    def upload_sequence_frame(self, idx, duration, pos_dic):
+    def stop_sequence(self):
         if self.is_connected():
-            c_idx = c_ubyte(idx)
-            data = self._load_frame(duration, pos_dic)
-            res = self._lib.scb_upload_sequence_frame(self._dev, c_idx, *data)
+            res = self._lib.scb_stop_sequence(self._dev)
             self._check_return_code(res)
 
+    def upload_sequence_frame(self, idx, duration, pos_dic):
+        """frames are sent all at once by upload_sequence_end"""
+        frame = seq_frame()
+        frame.duration = int(duration)
+        for i, pos in pos_dic.items():
+            frame.active_bm |= 1 << i
+            frame.position[i] = max(-32768, min(32767, int(pos * 32768)))
+        self._seq_frames[idx] = frame
+
     def upload_sequence_start(self, slot_id, frame_nb):
-        if self.is_connected():
-            c_id = c_uint32(int(slot_id))
-            c_nb = c_uint16(int(frame_nb))
-            res = self._lib.scb_upload_sequence_start(self._dev, c_id, c_nb)
-            self._check_return_code(res)
+        self._seq_slot = slot_id
+        self._seq_frames = [seq_frame() for i in range(frame_nb)]
 
     def upload_sequence_end(self, seq_description):
         if self.is_connected():
+            c_id = c_ubyte(int(self._seq_slot))
+            c_nb = c_uint16(len(self._seq_frames))
+            c_frames = (seq_frame * len(self._seq_frames))(*self._seq_frames)
             c_seq_desc = c_char_p(seq_description)
-            res = self._lib.scb_upload_sequence_end(self._dev, c_seq_desc)
+            res = self._lib.scb_upload_sequence(self._dev, c_id, c_frames, c_nb, c_seq_desc)
             self._check_return_code(res)
 
     def store_settings_to_slot(self, slot_id):
@@ -411,11 +726,15 @@ class OpenSCBBoard():
 
     def download_sequence(self, slot_id):
         if self.is_connected():
-            frame_nb = 64
             c_id = c_uint32(int(slot_id))
-            c_nb = c_uint8(int(frame_nb))
-            c_frame = (seq_frame * frame_nb)()
 
+            #first get the number of frames of the slot
+            c_nb = c_uint16(0)
+            frame_nb = self._lib.scb_download_sequence(self._dev, c_id, None, pointer(c_nb))
+            self._check_return_code(frame_nb)
+
+            c_nb = c_uint16(frame_nb)
+            c_frame = (seq_frame * frame_nb)()
             res = self._lib.scb_download_sequence(self._dev, c_id, c_frame, pointer(c_nb))
             self._check_return_code(res)
 
@@ -430,11 +749,87 @@ class OpenSCBBoard():
                 result.append((duration, pos_dic))
             return result
 
+    def load_frame_at(self, start_time, duration, pos_dic):
+        """start_time is a board time, see host_to_board_time"""
+        if self.is_connected():
+            data = self._load_frame(duration, pos_dic)
+            res = self._lib.scb_load_frame_at(self._dev, c_uint32(int(start_time)), *data)
+            self._check_return_code(res)
+
+    def get_board_time(self):
+        if self.is_connected():
+            c_time = c_uint32()
+            res = self._lib.scb_get_board_time(self._dev, byref(c_time))
+            self._check_return_code(res)
+            return c_time.value
+
+    def sync_clock(self, sample_nb=8):
+        """update board clock estimation, return (offset, drift, rtt)"""
+        if self.is_connected():
+            res = self._lib.scb_clock_sync(self._dev, byref(self._clock), c_int(sample_nb))
+            self._check_return_code(res)
+            return (self._clock.offset, self._clock.drift, self._clock.rtt)
+
+    def host_time(self):
+        return self._lib.scb_host_time_ms()
+
+    def host_to_board_time(self, host_time=None):
+        """convert a host time in ms (default: now) to board time"""
+        if host_time is None:
+            host_time = self.host_time()
+        return self._lib.scb_clock_host_to_board(byref(self._clock), c_double(host_time))
+
     def disable_frame(self):
         if self.is_connected():
             res = self._lib.scb_disable_frame(self._dev)
             self._check_return_code(res)
 
+    def queue_frame(self, duration, pos_dic):
+        """return (queued, number of free slots in the board frame queue)"""
+        if self.is_connected():
+            data = self._load_frame(duration, pos_dic)
+            c_free = c_ubyte()
+            res = self._lib.scb_queue_frame(self._dev, *(data + (byref(c_free),)))
+            self._check_return_code(res)
+            return (res > 0, c_free.value)
+
+    def set_frame_interpolation(self, interpolation):
+        if self.is_connected():
+            res = self._lib.scb_set_frame_interpolation(self._dev, c_ubyte(interpolation))
+            self._check_return_code(res)
+
+    def set_frame_notification(self, enable):
+        if self.is_connected():
+            res = self._lib.scb_set_frame_notification(self._dev, c_bool(enable))
+            self._check_return_code(res)
+
+    def set_goal_notification(self, enable, tolerance=0.0):
+        if self.is_connected():
+            res = self._lib.scb_set_goal_notification(self._dev, c_bool(enable),
+                                                      c_float(tolerance))
+            self._check_return_code(res)
+
+    def get_notification(self, timeout=100):
+        """return ('frame_done', done, free, idle), ('goal_reached', [reached], [moving])
+        or None if no notification was read, this consumes debug messages"""
+        if self.is_connected():
+            notif = scb_notification()
+            res = self._lib.scb_get_notification(self._dev, byref(notif), timeout)
+            if res <= 0:
+                return None
+            if notif.type == SCB_NOTIFY_FRAME_DONE:
+                return ('frame_done', notif.frame.done, notif.frame.free, bool(notif.frame.idle))
+            return ('goal_reached',
+                    [i for i in range(MAX_OUT_NB) if notif.goal.reached_bm & (1 << i)],
+                    [i for i in range(MAX_OUT_NB) if notif.goal.moving_bm & (1 << i)])
+
+    def get_frame_queue_free(self):
+        if self.is_connected():
+            c_free = c_ubyte()
+            res = self._lib.scb_get_frame_queue_free(self._dev, byref(c_free))
+            self._check_return_code(res)
+            return c_free.value
+
     def get_flash_overview(self):
         if self.is_connected():
             c_nb = c_ubyte(FLASH_SLOT_NB)
@@ -451,6 +846,14 @@ class OpenSCBBoard():
             self._check_return_code(res)
             return SlotHeader(c_slot[0].type, c_slot[0].desc)
 
+    def find_free_flash_slot(self):
+        """return the first uninitialized or empty slot, None if all slots are used"""
+        if self.is_connected():
+            res = self._lib.scb_find_free_flash_slot(self._dev)
+            self._check_return_code(res)
+            if res < FLASH_SLOT_NB:
+                return res
+
     def set_flash_slot_description(self, slot_id, description):
         if self.is_connected():
             c_id = c_ubyte(slot_id)
@@ -458,6 +861,136 @@ class OpenSCBBoard():
             res = self._lib.scb_set_flash_slot_description(self._dev, c_id, c_desc)
             self._check_return_code(res)
 
+    def get_output_latency(self):
+        """return (sample_nb, min_us, avg_us, max_us)"""
+        if self.is_connected():
+            stats = latency_stats()
+            res = self._lib.scb_get_output_latency(self._dev, byref(stats))
+            self._check_return_code(res)
+            return (stats.sample_nb, stats.min_us, stats.avg_us, stats.max_us)
+
+    def reset_output_latency(self):
+        if self.is_connected():
+            res = self._lib.scb_reset_output_latency(self._dev)
+            self._check_return_code(res)
+
+    def get_pid_conf(self):
+        if self.is_connected():
+            nb = self.get_output_nb()
+            conf = (pid_conf * nb)()
+            res = self._lib.scb_get_pid_conf(self._dev, conf, c_ubyte(nb))
+            self._check_return_code(res)
+            return [PidConf(c.kp, c.ki, c.kd, c.i_limit, c.gain_shift, c.feedback)
+                    for c in conf]
+
+    def set_pid_conf(self, conf):
+        if self.is_connected():
+            nb = c_ubyte(len(conf))
+            cf = (pid_conf * nb.value)()
+            for c, d in zip(cf, conf):
+                c.kp = d.kp
+                c.ki = d.ki
+                c.kd = d.kd
+                c.i_limit = d.i_limit
+                c.gain_shift = d.gain_shift
+                c.feedback = d.feedback
+            res = self._lib.scb_set_pid_conf(self._dev, cf, nb)
+            self._check_return_code(res)
+
+    def get_pid_setpoint(self):
+        return self._get_out_array(c_float, self._lib.scb_get_pid_setpoint)
+
+    def set_pid_setpoint(self, setpoints):
+        self._set_out_array(c_float, setpoints, self._lib.scb_set_pid_setpoint)
+
+    def set_pid_enabled(self, enabled):
+        self._set_out_array(c_bool, enabled, self._lib.scb_set_pid_enabled)
+
+    def get_gait_conf(self):
+        if self.is_connected():
+            conf = gait_conf()
+            res = self._lib.scb_get_gait_conf(self._dev, byref(conf))
+            self._check_return_code(res)
+            return GaitConf(conf.period, conf.stride, conf.lift, conf.tuck)
+
+    def set_gait_conf(self, conf):
+        if self.is_connected():
+            cf = gait_conf(conf.period, conf.stride, conf.lift, conf.tuck)
+            res = self._lib.scb_set_gait_conf(self._dev, byref(cf))
+            self._check_return_code(res)
+
+    def get_gait_legs(self):
+        if self.is_connected():
+            legs = (gait_leg * GAIT_LEG_NB)()
+            res = self._lib.scb_get_gait_legs(self._dev, legs, c_ubyte(GAIT_LEG_NB))
+            self._check_return_code(res)
+            return [GaitLeg(l.coxa, l.femur, l.tibia, l.side, l.coxa_center,
+                            l.femur_ground, l.tibia_ground) for l in legs]
+
+    def set_gait_legs(self, legs):
+        if self.is_connected():
+            nb = c_ubyte(len(legs))
+            lg = (gait_leg * nb.value)()
+            for l, d in zip(lg, legs):
+                l.coxa = d.coxa
+                l.femur = d.femur
+                l.tibia = d.tibia
+                l.side = d.side
+                l.coxa_center = d.coxa_center
+                l.femur_ground = d.femur_ground
+                l.tibia_ground = d.tibia_ground
+            res = self._lib.scb_set_gait_legs(self._dev, lg, nb)
+            self._check_return_code(res)
+
+    def set_gait_type(self, gait):
+        if self.is_connected():
+            res = self._lib.scb_set_gait_type(self._dev, c_ubyte(gait))
+            self._check_return_code(res)
+
+    def set_gait_motion(self, speed, heading):
+        if self.is_connected():
+            res = self._lib.scb_set_gait_motion(self._dev, c_float(speed), c_float(heading))
+            self._check_return_code(res)
+
+    def set_gait_enabled(self, enable):
+        if self.is_connected():
+            res = self._lib.scb_set_gait_enabled(self._dev, c_bool(enable))
+            self._check_return_code(res)
+
+    def get_core_timing(self):
+        """return (cycle_nb, missed_nb, overrun_nb, max_cycle_us, max_late_ms)"""
+        if self.is_connected():
+            stats = core_timing_stats()
+            res = self._lib.scb_get_core_timing(self._dev, byref(stats))
+            self._check_return_code(res)
+            return (stats.cycle_nb, stats.missed_nb, stats.overrun_nb,
+                    stats.max_cycle_us, stats.max_late_ms)
+
+    def get_stage_timing(self):
+        """return a list of (period_ms, run_nb, missed_nb, overrun_nb, max_run_us,
+        max_late_ms), one per core stage"""
+        if self.is_connected():
+            res_list = []
+            for i in range(CORE_STAGE_MAX_NB):
+                stats = core_stage_stats()
+                res = self._lib.scb_get_stage_timing(self._dev, c_ubyte(i), byref(stats))
+                self._check_return_code(res)
+                if stats.period_ms == 0:
+                    break
+                res_list.append((stats.period_ms, stats.run_nb, stats.missed_nb,
+                                 stats.overrun_nb, stats.max_run_us, stats.max_late_ms))
+            return res_list
+
+    def reset_core_timing(self):
+        if self.is_connected():
+            res = self._lib.scb_reset_core_timing(self._dev)
+            self._check_return_code(res)
+
+    def set_overrun_policy(self, policy):
+        if self.is_connected():
+            res = self._lib.scb_set_overrun_policy(self._dev, c_ubyte(policy))
+            self._check_return_code(res)
+
 
 
 import Queue
@@ -473,11 +1006,21 @@ class OpenSCBSimu():
         self._inputs = [0.0, ] * self._in_nb
         self._outputs = [0.0, ] * self._out_nb
         self._speeds = [0, ] * self._out_nb
+        self._accel = [0, ] * self._out_nb
+        self._jerk = [0, ] * self._out_nb
         self._names = [a for a in 'ABCDEFGHIJKLMNOPQRSTUVWXYZ']
         self._out_enabled = [False, ] * self._out_nb
+        self._pid_conf = [PidConf(0, 0, 0, 0x7FFF, 0, i % self._in_nb) for i in range(self._out_nb)]
+        self._pid_setpoint = [0.0, ] * self._out_nb
+        self._pid_enabled = [False, ] * self._out_nb
+        self._gait_conf = GaitConf(1000, 0x7FFF // 10, 0x7FFF // 10, 0)
+        self._gait_legs = [GaitLeg(3*i, 3*i + 1, 3*i + 2, 1 if i < GAIT_LEG_NB // 2 else -1, 0, 0, 0)
+                           for i in range(GAIT_LEG_NB)]
 
         self._in_calib = [InputCalib(1000, 2000, 3000) for _ in range(self._in_nb)]
         self._out_calib = [OuputCalib(1000, 4000, 3000, 2500) for _ in range(self._out_nb)]
+        self._out_lut = [OutputLut(False, [2500 + 750*(k - 4) for k in range(OUTPUT_LUT_POINT_NB)])
+                         for _ in range(self._out_nb)]
         self._flash_slot = [SlotHeader(SlotHeader.SLOT_UNINIT, "Simu flash") for _ in range(8)]
 
         self.__dbg_msg = Queue.Queue()
@@ -533,6 +1076,12 @@ class OpenSCBSimu():
     def get_output_speed(self):
         return self._speeds
 
+    def get_output_accel(self):
+        return self._accel
+
+    def get_output_jerk(self):
+        return self._jerk
+
     def get_output_names(self):
         return self._names
 
@@ -551,12 +1100,39 @@ class OpenSCBSimu():
     def set_output_speed(self, speeds):
         self._speeds = speeds
 
+    def set_output_accel(self, accel):
+        self._accel = accel
+
+    def set_output_jerk(self, jerk):
+        self._jerk = jerk
+
     def set_mode(self, mode):
         self.__log("Setting board mode: %d" % mode)
 
     def save_sys_conf(self):
         self.__log("Saving system conf")
 
+    def load_sys_conf(self):
+        self.__log("Loading system conf")
+
+    def get_sys_conf_digest(self):
+        return (0, [0, ] * SYS_CONF_SECTION_NB)
+
+    def compute_sys_conf_digest(self, image):
+        return (0, [0, ] * SYS_CONF_SECTION_NB)
+
+    def compare_sys_conf_digest(self, a, b):
+        return sum(1 << i for i in range(SYS_CONF_SECTION_NB) if a[1][i] != b[1][i])
+
+    def get_sys_conf_diff(self, image):
+        return 0
+
+    def get_sys_conf(self):
+        return sys_conf_image()
+
+    def set_sys_conf(self, image):
+        self.__log("Setting system conf")
+
 
     def in_calib_set_center(self):
         pass
@@ -570,16 +1146,106 @@ class OpenSCBSimu():
     def set_out_calib_values(self, calib):
         self._out_calib = calib
 
+    def get_out_lut(self):
+        return self._out_lut
+
+    def set_out_lut(self, luts):
+        self._out_lut = luts
+
     def set_out_calib_raw(self, no, value):
         self.__log("Out %d raw: %d" % (no, value))
 
+    def set_input_stream(self, enable):
+        self.__log("Input stream: %d" % enable)
+
+    def get_input_stream_sample(self, timeout=100):
+        return None
+
+    def get_output_latency(self):
+        return (0, 0, 0, 0)
+
+    def reset_output_latency(self):
+        pass
+
+    def get_core_timing(self):
+        return (0, 0, 0, 0, 0)
+
+    def get_stage_timing(self):
+        return [(14, 0, 0, 0, 0, 0)]
+
+    def get_pid_conf(self):
+        return self._pid_conf
+
+    def set_pid_conf(self, conf):
+        self._pid_conf = conf
+
+    def get_pid_setpoint(self):
+        return self._pid_setpoint
+
+    def set_pid_setpoint(self, setpoints):
+        self._pid_setpoint = setpoints
+
+    def set_pid_enabled(self, enabled):
+        self._pid_enabled = enabled
+
+    def get_gait_conf(self):
+        return self._gait_conf
+
+    def set_gait_conf(self, conf):
+        self._gait_conf = conf
+
+    def get_gait_legs(self):
+        return self._gait_legs
+
+    def set_gait_legs(self, legs):
+        self._gait_legs = legs
+
+    def set_gait_type(self, gait):
+        self.__log("Gait type: %d" % gait)
+
+    def set_gait_motion(self, speed, heading):
+        self.__log("Gait motion: %f, %f" % (speed, heading))
+
+    def set_gait_enabled(self, enable):
+        self.__log("Gait enabled: %d" % enable)
+
+    def reset_core_timing(self):
+        pass
+
+    def set_overrun_policy(self, policy):
+        self.__log("Core overrun policy: %d" % policy)
+
     def load_frame(self, duration, pos_dic):
         pass
+    def load_frame_at(self, start_time, duration, pos_dic):
+        pass
+    def get_board_time(self):
+        return 0
+    def sync_clock(self, sample_nb=8):
+        return (0.0, 0.0, 0.0)
+    def host_time(self):
+        return 0.0
+    def host_to_board_time(self, host_time=None):
+        return 0
     def disable_frame(self):
         pass
+    def queue_frame(self, duration, pos_dic):
+        return (True, FRAME_QUEUE_SIZE)
+    def get_frame_queue_free(self):
+        return FRAME_QUEUE_SIZE
+    def set_frame_interpolation(self, interpolation):
+        self.__log("Frame interpolation: %d" % interpolation)
+    def set_frame_notification(self, enable):
+        self.__log("Frame notification: %d" % enable)
+    def set_goal_notification(self, enable, tolerance=0.0):
+        self.__log("Goal notification: %d" % enable)
+    def get_notification(self, timeout=100):
+        return None
 
     def play_sequence(self, slot_id):
         self.__log("Playing sequence in slotid: %d" % slot_id)
+    def stop_sequence(self):
+        self.__log("Stopping sequence")
     def upload_sequence_frame(self, idx, duration, pos_dic):
         self.__log("* Saving sequence frame: %d" % idx)
     def upload_sequence_start(self, slot_id, frame_nb):
@@ -606,6 +1272,10 @@ class OpenSCBSimu():
         return self._flash_slot
     def get_flash_slot(self, slot_id):
         return self._flash_slot[slot_id]
+    def find_free_flash_slot(self):
+        for i, s in enumerate(self._flash_slot):
+            if s.type in (SlotHeader.SLOT_UNINIT, SlotHeader.SLOT_EMPTY):
+                return i
     def set_flash_slot_description(self, slot_id, description):
         self._flash_slot[slot_id].desc = description
 
@@ -25,6 +25,12 @@
 #include <string.h>
 #include <math.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
 
 
 float scb_degrees_to_goal(float degrees)
@@ -66,12 +72,45 @@ int scb_set_output_goal(openscb_dev dev, float *outputs, int nb)
 }
 
 
-int scb_set_out_speed(openscb_dev dev, uint8_t *speeds, int nb)
+int scb_set_out_speed(openscb_dev dev, const uint16_t *speeds, int nb)
 {
-    return scb_fragment_and_send_data(dev, speeds, nb, sizeof(uint8_t),
+    uint16_t tmp[MAX_OUT_NB];
+    int i;
+
+    nb = MIN(nb, MAX_OUT_NB);
+    for(i = 0; i < nb; i++)
+        tmp[i] = BE16(speeds[i]);
+
+    return scb_fragment_and_send_data(dev, tmp, nb, sizeof(uint16_t),
             PCCOM_SYS_CONF, SET_OUTPUT_MAX_SPEED);
 }
 
+int scb_set_out_accel(openscb_dev dev, const uint16_t *accel, int nb)
+{
+    uint16_t tmp[MAX_OUT_NB];
+    int i;
+
+    nb = MIN(nb, MAX_OUT_NB);
+    for(i = 0; i < nb; i++)
+        tmp[i] = BE16(accel[i]);
+
+    return scb_fragment_and_send_data(dev, tmp, nb, sizeof(uint16_t),
+            PCCOM_SYS_CONF, SET_OUTPUT_MAX_ACCEL);
+}
+
+int scb_set_out_jerk(openscb_dev dev, const uint32_t *jerk, int nb)
+{
+    uint32_t tmp[MAX_OUT_NB];
+    int i;
+
+    nb = MIN(nb, MAX_OUT_NB);
+    for(i = 0; i < nb; i++)
+        tmp[i] = BE32(jerk[i]);
+
+    return scb_fragment_and_send_data(dev, tmp, nb, sizeof(uint32_t),
+            PCCOM_SYS_CONF, SET_OUTPUT_MAX_JERK);
+}
+
 int scb_get_input_nb(openscb_dev dev, uint8_t *nb)
 {
     return scb_request_and_defragment(dev, nb, 1, sizeof(uint8_t),
@@ -102,10 +141,48 @@ int scb_get_output_goal(openscb_dev dev, float *goal, uint8_t nb)
 }
 
 
-int scb_get_output_speed(openscb_dev dev, uint8_t *speeds, uint8_t nb)
+int scb_get_output_speed(openscb_dev dev, uint16_t *speeds, uint8_t nb)
 {
-    return scb_request_and_defragment(dev, speeds, nb, sizeof(uint8_t),
+    int res, i;
+
+    res = scb_request_and_defragment(dev, speeds, nb, sizeof(uint16_t),
             PCCOM_SYS_CONF, REQ_OUTPUT_MAX_SPEED);
+    if(res < 0)
+        return res;
+
+    for(i = 0; i < nb; i++)
+        speeds[i] = BE16(speeds[i]);
+    return res;
+}
+
+
+int scb_get_output_accel(openscb_dev dev, uint16_t *accel, uint8_t nb)
+{
+    int res, i;
+
+    res = scb_request_and_defragment(dev, accel, nb, sizeof(uint16_t),
+            PCCOM_SYS_CONF, REQ_OUTPUT_MAX_ACCEL);
+    if(res < 0)
+        return res;
+
+    for(i = 0; i < nb; i++)
+        accel[i] = BE16(accel[i]);
+    return res;
+}
+
+
+int scb_get_output_jerk(openscb_dev dev, uint32_t *jerk, uint8_t nb)
+{
+    int res, i;
+
+    res = scb_request_and_defragment(dev, jerk, nb, sizeof(uint32_t),
+            PCCOM_SYS_CONF, REQ_OUTPUT_MAX_JERK);
+    if(res < 0)
+        return res;
+
+    for(i = 0; i < nb; i++)
+        jerk[i] = BE32(jerk[i]);
+    return res;
 }
 
 
@@ -171,18 +248,259 @@ int scb_load_frame(openscb_dev dev, uint32_t duration, const float *position,
 }
 
 
+int scb_load_frame_at(openscb_dev dev, uint32_t start_time, uint32_t duration,
+        const float *position, const bool *active, uint8_t nb)
+{
+    pccomm_packet_t packet;
+    frame_at_t frame_at;
+
+    frame_at.start_time = BE32(start_time);
+    scb_build_frame(&frame_at.frame, duration, position, active, nb);
+
+    scb_build_packet(PCCOM_POS_CTRL, POS_CTRL_LOAD_FRAME_AT, 0, &frame_at,
+            sizeof(frame_at), &packet);
+    return scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+}
+
+
 int scb_disable_frame(openscb_dev dev)
 {
     return scb_send_request(dev, PCCOM_POS_CTRL, POS_CTRL_DISABLE);
 }
 
 
+int scb_queue_frame(openscb_dev dev, uint32_t duration, const float *position,
+        const bool *active, uint8_t nb, uint8_t *free)
+{
+    int ret;
+    pccomm_packet_t packet;
+    frame_queue_status_t *status = (frame_queue_status_t *)packet.data;
+
+    ret = scb_send_frame(dev, PCCOM_POS_CTRL, POS_CTRL_QUEUE_FRAME, 0,
+            duration, position, active, nb);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    ret = scb_get_reply(dev, &packet, PCCOM_POS_CTRL, POS_CTRL_QUEUE_FRAME);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    if(free != NULL)
+    {
+        *free = status->free;
+    }
+    return status->queued;
+}
+
+
+int scb_get_frame_queue_free(openscb_dev dev, uint8_t *free)
+{
+    int ret;
+    pccomm_packet_t packet;
+    frame_queue_status_t *status = (frame_queue_status_t *)packet.data;
+
+    ret = scb_request_and_get_reply(dev, &packet, PCCOM_POS_CTRL, POS_CTRL_REQ_QUEUE_STATUS, 0);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    *free = status->free;
+    return 0;
+}
+
+
+int scb_set_frame_interpolation(openscb_dev dev, uint8_t interpolation)
+{
+    return scb_send_request_index(dev, PCCOM_POS_CTRL, POS_CTRL_SET_INTERPOLATION, interpolation);
+}
+
+
+int scb_set_frame_notification(openscb_dev dev, bool enable)
+{
+    return scb_send_request_index(dev, PCCOM_POS_CTRL, POS_CTRL_SET_NOTIFICATION,
+            enable ? 1 : 0);
+}
+
+
+int scb_set_goal_notification(openscb_dev dev, bool enable, float tolerance)
+{
+    pccomm_packet_t packet;
+    _dsp16_t conv_data;
+    conv_data = scb_convert_float_dsp16_BE(tolerance);
+
+    scb_build_packet(PCCOM_CORE, SET_GOAL_NOTIFICATION, enable ? 1 : 0, &conv_data,
+            sizeof(_dsp16_t), &packet);
+    return scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+}
+
+
+int scb_get_notification(openscb_dev dev, scb_notification_t *notif, int timeout)
+{
+    int ret;
+    pccomm_packet_t packet;
+    const pccomm_msg_header_t *header = &packet.header;
+    int size;
+
+    memset(&packet, 0, sizeof(packet));
+    ret = scb_get_debug_message(dev, (char*)&packet, sizeof(packet), timeout);
+    if(ret < 0)
+    {
+        return ret;
+    }
+    size = header->size - sizeof(pccomm_msg_header_t);
+
+    if(header->module == (PCCOM_POS_CTRL | PCCOM_MASTER_PACKET_FLAG) &&
+       header->command == POS_CTRL_FRAME_DONE_NOTIFICATION &&
+       size >= (int)sizeof(frame_done_notification_t))
+    {
+        notif->type = SCB_NOTIFY_FRAME_DONE;
+        memcpy(&notif->frame, packet.data, sizeof(notif->frame));
+        return 1;
+    }
+
+    if(header->module == (PCCOM_CORE | PCCOM_MASTER_PACKET_FLAG) &&
+       header->command == GOAL_REACHED_NOTIFICATION &&
+       size >= (int)sizeof(goal_reached_notification_t))
+    {
+        goal_reached_notification_t tmp;
+        memcpy(&tmp, packet.data, sizeof(tmp));
+        notif->type = SCB_NOTIFY_GOAL_REACHED;
+        notif->goal.reached_bm = BE32(tmp.reached_bm);
+        notif->goal.moving_bm = BE32(tmp.moving_bm);
+        return 1;
+    }
+
+    return 0;
+}
+
+
 int scb_play_sequence_slot(openscb_dev dev, uint8_t slot_id)
 {
     return scb_send_request_index(dev, PCCOM_SEQ_CTRL, SEQ_CTRL_PLAY_SLOT, slot_id);
 }
 
 
+int scb_stop_sequence(openscb_dev dev)
+{
+    return scb_send_request(dev, PCCOM_SEQ_CTRL, SEQ_CTRL_STOP);
+}
+
+
+
+double scb_host_time_ms(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return count.QuadPart * 1000.0 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+
+int scb_get_board_time(openscb_dev dev, uint32_t *board_time)
+{
+    int ret;
+    pccomm_packet_t packet;
+
+    ret = scb_request_and_get_reply(dev, &packet, PCCOM_SYSTEM, REQ_BOARD_TIME, 0);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    *board_time = BE32(*(uint32_t*)packet.data);
+    return 0;
+}
+
+
+void scb_clock_init(scb_clock_t *clock)
+{
+    memset(clock, 0, sizeof(scb_clock_t));
+}
+
+
+int scb_clock_sync(openscb_dev dev, scb_clock_t *clock, int sample_nb)
+{
+    int i, ret;
+    double best_rtt = -1;
+    double best_host = 0;
+    uint32_t best_board = 0;
+    double t, offset, denom;
+
+    for(i=0; i<sample_nb; i++)
+    {
+        uint32_t board;
+        double start = scb_host_time_ms();
+        ret = scb_get_board_time(dev, &board);
+        double end = scb_host_time_ms();
+
+        if(ret < 0)
+        {
+            return ret;
+        }
+
+        //board time is read somewhere during the exchange, assume the middle
+        if(best_rtt < 0 || end - start < best_rtt)
+        {
+            best_rtt = end - start;
+            best_host = (start + end) / 2;
+            best_board = board;
+        }
+    }
+
+    if(best_rtt < 0)
+    {
+        return -1;
+    }
+    clock->rtt = best_rtt;
+
+    if(clock->sync_nb == 0)
+    {
+        clock->ref_host = best_host;
+        offset = (double)best_board - best_host;
+    }
+    else
+    {
+        //board time wraps around, measure from the current estimation
+        uint32_t predicted = scb_clock_host_to_board(clock, best_host);
+        offset = clock->offset + clock->drift * (best_host - clock->ref_host) +
+                (int32_t)(best_board - predicted);
+    }
+
+    t = best_host - clock->ref_host;
+    clock->sync_nb++;
+    clock->sum_t += t;
+    clock->sum_o += offset;
+    clock->sum_tt += t * t;
+    clock->sum_to += t * offset;
+
+    denom = clock->sync_nb * clock->sum_tt - clock->sum_t * clock->sum_t;
+    if(clock->sync_nb >= 2 && denom > 0)
+    {
+        clock->drift = (clock->sync_nb * clock->sum_to - clock->sum_t * clock->sum_o) / denom;
+    }
+    clock->offset = (clock->sum_o - clock->drift * clock->sum_t) / clock->sync_nb;
+
+    return 0;
+}
+
+
+uint32_t scb_clock_host_to_board(const scb_clock_t *clock, double host_time)
+{
+    double board = host_time + clock->offset + clock->drift * (host_time - clock->ref_host);
+    return (uint32_t)(int64_t)floor(board + 0.5);
+}
+
 
 int scb_check_firmware_version(openscb_dev dev, bool *compatible, char *version, int size)
 {
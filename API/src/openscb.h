@@ -33,11 +33,24 @@ extern "C" {
  *
  * TODO: need a function to find an output by name
  *
- * TODO: need a goal reached function (ie: bool is_servo_moving(int nb))
- *
  */
 
 
+/**
+ * Notifications pushed by the board, see scb_get_notification
+ */
+enum {
+    SCB_NOTIFY_FRAME_DONE,      ///< frames have been completed
+    SCB_NOTIFY_GOAL_REACHED,    ///< outputs reached their goal
+};
+
+typedef struct {
+    uint8_t type;                       ///< SCB_NOTIFY_FRAME_DONE or SCB_NOTIFY_GOAL_REACHED
+    frame_done_notification_t frame;    ///< valid for SCB_NOTIFY_FRAME_DONE
+    goal_reached_notification_t goal;   ///< valid for SCB_NOTIFY_GOAL_REACHED (native format)
+} scb_notification_t;
+
+
 /**
  * Convert degrees to servo goal value
  *
@@ -102,21 +115,33 @@ int scb_set_output_goal(openscb_dev dev, float *outputs, int nb);
  * Send output max speed to the board
  *
  * \param dev handle to openscb device
- * \param speeds array of speed values, float format [-1..1]
+ * \param speeds array of speed values in degrees/s, 0 disables speed limit
  * \param nb number of element in the speed array
  * \return <0 on error
  */
-int scb_set_out_speed(openscb_dev dev, uint8_t *speeds, int nb);
+int scb_set_out_speed(openscb_dev dev, const uint16_t *speeds, int nb);
 
 /**
- * Send output max acceleration values to the board
+ * Send output max acceleration values to the board, the output speeds up
+ * and slows down with a trapezoidal profile. 0 disables acceleration limit.
  *
  * \param dev handle to openscb device
- * \param accel array of accel values, in float format [-1..1]
+ * \param accel array of accel values in degrees/s^2
  * \param nb number of element in the accel array
  * \return <0 on error
  */
-int scb_set_out_accel(openscb_dev dev, uint8_t *accel, int nb);
+int scb_set_out_accel(openscb_dev dev, const uint16_t *accel, int nb);
+
+/**
+ * Send output max jerk values to the board, outputs with both an acceleration
+ * and a jerk limit follow a S-curve profile. 0 disables jerk limit.
+ *
+ * \param dev handle to openscb device
+ * \param jerk array of jerk values in degrees/s^3
+ * \param nb number of element in the jerk array
+ * \return <0 on error
+ */
+int scb_set_out_jerk(openscb_dev dev, const uint32_t *jerk, int nb);
 
 
 /**
@@ -143,23 +168,34 @@ int scb_get_output_values(openscb_dev dev, float *outputs, uint8_t nb);
  * Get current value of max speed for each output
  *
  * \param dev handle to openscb device
- * \param speeds[out] list of speed values
+ * \param speeds[out] list of speed values in degrees/s
  * \param nb number of values to get from the board
  * (function will timeout if not all values can be read)
  * \return <0 on error
  */
-int scb_get_output_speed(openscb_dev dev, uint8_t *speeds, uint8_t nb);
+int scb_get_output_speed(openscb_dev dev, uint16_t *speeds, uint8_t nb);
 
 /**
  * Get current value of acceleration for each output
  *
  * \param dev handle to openscb device
- * \param outputs[out] list of accel values
+ * \param accel[out] list of accel values in degrees/s^2
  * \param nb number of values to get from the board
  * (function will timeout if not all values can be read)
  * \return <0 on error
  */
-int scb_get_output_accel(openscb_dev dev, uint8_t *accel, uint8_t nb);
+int scb_get_output_accel(openscb_dev dev, uint16_t *accel, uint8_t nb);
+
+/**
+ * Get current value of jerk limit for each output
+ *
+ * \param dev handle to openscb device
+ * \param jerk[out] list of jerk values in degrees/s^3
+ * \param nb number of values to get from the board
+ * (function will timeout if not all values can be read)
+ * \return <0 on error
+ */
+int scb_get_output_jerk(openscb_dev dev, uint32_t *jerk, uint8_t nb);
 
 
 /**
@@ -175,6 +211,22 @@ int scb_get_output_accel(openscb_dev dev, uint8_t *accel, uint8_t nb);
 int scb_load_frame(openscb_dev dev, uint32_t duration, const float *position,
         const bool *active, uint8_t nb);
 
+/**
+ * Load a frame on the board that starts at a given board time, outputs stay
+ * where they are until then. Frames sent ahead of time to several boards
+ * start together, whatever the USB latency.
+ *
+ * \param dev handle to openscb device
+ * \param start_time board time in ms, see scb_clock_host_to_board
+ * \param duration time until the frame is reached
+ * \param position list of position value for each output
+ * \param active whether each output is enabled or not
+ * \param nb size of "position" and "active" array
+ * \return <0 on error
+ */
+int scb_load_frame_at(openscb_dev dev, uint32_t start_time, uint32_t duration,
+        const float *position, const bool *active, uint8_t nb);
+
 /**
  * Stop and cancel currently loaded frame (in move or not)
  *
@@ -183,6 +235,76 @@ int scb_load_frame(openscb_dev dev, uint32_t duration, const float *position,
  */
 int scb_disable_frame(openscb_dev dev);
 
+/**
+ * Queue a frame on the board, it will be played right after the frames
+ * already loaded or queued, without waiting for the host. Loading a frame
+ * with scb_load_frame or disabling frames flushes the queue.
+ *
+ * \param dev handle to openscb device
+ * \param duration time to reach the frame from the previous one
+ * \param position list of position value for each output
+ * \param active whether each output is enabled or not
+ * \param nb size of "position" and "active" array
+ * \param free[out] number of frames that can still be queued, can be NULL
+ * \return <0 on error, 0 if the queue was full (frame is dropped), 1 if queued
+ */
+int scb_queue_frame(openscb_dev dev, uint32_t duration, const float *position,
+        const bool *active, uint8_t nb, uint8_t *free);
+
+/**
+ * Get the number of frames that can still be queued on the board
+ *
+ * \param dev handle to openscb device
+ * \param free[out] number of free slots in the frame queue
+ * \return <0 on error
+ */
+int scb_get_frame_queue_free(openscb_dev dev, uint8_t *free);
+
+/**
+ * Select interpolation between frames. With FRAME_INTERP_CUBIC, speed is
+ * continuous across frames as long as the next frame is queued before the
+ * current one starts.
+ *
+ * \param dev handle to openscb device
+ * \param interpolation FRAME_INTERP_LINEAR (default) or FRAME_INTERP_CUBIC
+ * \return <0 on error
+ */
+int scb_set_frame_interpolation(openscb_dev dev, uint8_t interpolation);
+
+/**
+ * Enable notifications pushed by the board each time frames loaded or
+ * queued with the API are completed, instead of polling the queue status.
+ *
+ * \param dev handle to openscb device
+ * \param enable true to receive SCB_NOTIFY_FRAME_DONE notifications
+ * \return <0 on error
+ */
+int scb_set_frame_notification(openscb_dev dev, bool enable);
+
+/**
+ * Enable notifications pushed by the board when outputs reach their goal.
+ * Goals are the values requested by controllers (API goals, frames...),
+ * outputs reach them once speed limits let them.
+ *
+ * \param dev handle to openscb device
+ * \param enable true to receive SCB_NOTIFY_GOAL_REACHED notifications
+ * \param tolerance maximum distance between an output and its goal [0..1]
+ * \return <0 on error
+ */
+int scb_set_goal_notification(openscb_dev dev, bool enable, float tolerance);
+
+/**
+ * Wait for a notification pushed by the board on the master endpoint.
+ * Other messages read by this function (traces, streams) are lost.
+ *
+ * \param dev handle to openscb device
+ * \param notif[out] received notification
+ * \param timeout maximum time to wait for a message in ms
+ * \return 1 if a notification was received, 0 if the message was something
+ *  else, <0 on error
+ */
+int scb_get_notification(openscb_dev dev, scb_notification_t *notif, int timeout);
+
 
 /**
  * Load the sequence from flash slot and play it
@@ -193,6 +315,14 @@ int scb_disable_frame(openscb_dev dev);
  */
 int scb_play_sequence_slot(openscb_dev dev, uint8_t slot_id);
 
+/**
+ * Stop the sequence being played, outputs are released
+ *
+ * \param dev handle to openscb device
+ * \return <0 on error
+ */
+int scb_stop_sequence(openscb_dev dev);
+
 
 /**
  * Enable or disable output globally
@@ -226,6 +356,68 @@ int scb_get_out_enabled(openscb_dev dev, bool *enabled, uint8_t nb);
 int scb_set_out_controlled(openscb_dev dev, const bool *controlled, uint8_t nb);
 
 
+/**
+ * Board clock estimated from the host clock:
+ * board = host + offset + drift * (host - ref_host)
+ */
+typedef struct {
+    double ref_host;        ///< host time of the first synchronisation (ms)
+    double offset;          ///< board time minus host time at ref_host (ms)
+    double drift;           ///< board clock drift relative to host clock
+    double rtt;             ///< round trip time of the last synchronisation (ms)
+
+    //least squares fit of all measured offsets, times relative to ref_host
+    uint32_t sync_nb;
+    double sum_t;
+    double sum_o;
+    double sum_tt;
+    double sum_to;
+} scb_clock_t;
+
+/**
+ * Get host monotonic time, the time base of scb_clock_t
+ *
+ * \return time in ms
+ */
+double scb_host_time_ms(void);
+
+/**
+ * Get board time, frame start times are in this time base
+ *
+ * \param dev handle to openscb device
+ * \param board_time[out] board time in ms, wraps around after 49 days
+ * \return <0 on error
+ */
+int scb_get_board_time(openscb_dev dev, uint32_t *board_time);
+
+/**
+ * Reset a clock estimation, before the first scb_clock_sync
+ */
+void scb_clock_init(scb_clock_t *clock);
+
+/**
+ * Measure board time against host time and update the clock estimation.
+ * The exchange with the shortest round trip is kept. Offset is known after
+ * the first call, drift after the next ones: calling it every few seconds
+ * keeps the estimation within a millisecond or so.
+ *
+ * \param dev handle to openscb device
+ * \param clock clock estimation to update
+ * \param sample_nb number of time requests
+ * \return <0 on error
+ */
+int scb_clock_sync(openscb_dev dev, scb_clock_t *clock, int sample_nb);
+
+/**
+ * Convert a host time to board time
+ *
+ * \param clock synchronised clock estimation
+ * \param host_time host time in ms, see scb_host_time_ms
+ * \return board time in ms
+ */
+uint32_t scb_clock_host_to_board(const scb_clock_t *clock, double host_time);
+
+
 /**
  * Get the version of the firmware
  *
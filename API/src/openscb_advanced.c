@@ -67,6 +67,19 @@ int scb_get_out_calib_values(openscb_dev dev, output_calib_data_t *calib, uint8_
             PCCOM_SYS_CONF, REQ_OUTPUT_CALIB_VALUE);
 }
 
+int scb_set_out_lut(openscb_dev dev, output_lut_t *lut, uint8_t nb)
+{
+    return scb_fragment_and_send_data(dev, lut, nb, sizeof(output_lut_t),
+            PCCOM_SYS_CONF, SET_OUTPUT_LUT);
+}
+
+
+int scb_get_out_lut(openscb_dev dev, output_lut_t *lut, uint8_t nb)
+{
+    return scb_request_and_defragment(dev, lut, nb, sizeof(output_lut_t),
+            PCCOM_SYS_CONF, REQ_OUTPUT_LUT);
+}
+
 int scb_set_out_calib_raw(openscb_dev dev, uint8_t out_id, _dsp16_t value)
 {
     pccomm_packet_t packet;
@@ -77,6 +90,47 @@ int scb_set_out_calib_raw(openscb_dev dev, uint8_t out_id, _dsp16_t value)
 }
 
 
+int scb_set_input_stream(openscb_dev dev, bool enable)
+{
+    return scb_send_request_index(dev, PCCOM_CORE_CALIBRATION, SET_INPUT_CALIB_STREAM,
+            enable ? 1 : 0);
+}
+
+
+int scb_get_input_stream_sample(openscb_dev dev, input_stream_sample_t *sample,
+        int timeout)
+{
+    int ret, i;
+    pccomm_packet_t packet;
+    input_stream_sample_t tmp;
+    const pccomm_msg_header_t *header = &packet.header;
+
+    memset(&packet, 0, sizeof(packet));
+    ret = scb_get_debug_message(dev, (char*)&packet, sizeof(packet), timeout);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    if(header->module != (PCCOM_CORE_CALIBRATION | PCCOM_MASTER_PACKET_FLAG) ||
+       header->command != INPUT_CALIB_STREAM_SAMPLE ||
+       header->size < sizeof(pccomm_msg_header_t) + sizeof(tmp))
+    {
+        return 0;
+    }
+
+    memcpy(&tmp, packet.data, sizeof(tmp));
+    sample->cycle = BE16(tmp.cycle);
+    sample->active_bm = BE16(tmp.active_bm);
+    for(i=0; i<MAX_IN_NB; i++)
+    {
+        sample->raw[i] = BE16(tmp.raw[i]);
+    }
+
+    return 1;
+}
+
+
 int scb_get_input_mapping(openscb_dev dev, uint8_t *mapping, uint8_t nb)
 {
     return scb_request_and_defragment(dev, mapping, nb, sizeof(uint8_t),
@@ -106,51 +160,188 @@ int scb_set_output_name(openscb_dev dev, io_name_t *names, uint8_t nb)
 
 
 
-int scb_upload_sequence_start(openscb_dev dev, uint8_t slot_id, uint16_t frame_nb)
+int scb_upload_sequence(openscb_dev dev, uint8_t slot_id, const frame_t *frames,
+        uint16_t frame_nb, const char *seq_desc)
 {
+    int ret;
+    int i;
+    int size = SCB_SEQ_HEADER_SIZE;
+    uint8_t data[FLASH_SLOT_DATA_SIZE];
+    uint16_t be_size;
+    scb_seq_codec_t codec;
     pccomm_packet_t packet;
-    frame_nb = BE16(frame_nb);
 
-    scb_build_packet(PCCOM_SEQ_CTRL, SEQ_CTRL_UPLOAD_SLOT_START, slot_id, &frame_nb, sizeof(frame_nb), &packet);
-    return scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+    /*encode the whole sequence*/
+    data[0] = frame_nb >> 8;
+    data[1] = frame_nb & 0xFF;
+    scb_seq_codec_init(&codec);
+    for(i=0; i<frame_nb; i++)
+    {
+        ret = scb_seq_encode_frame(&codec, &frames[i], data + size, sizeof(data) - size);
+        if(ret < 0)
+        {
+            return ret;
+        }
+        size += ret;
+    }
+
+    /*board erases the slot*/
+    be_size = BE16((uint16_t)size);
+    scb_build_packet(PCCOM_SEQ_CTRL, SEQ_CTRL_UPLOAD_SLOT_START, slot_id, &be_size, sizeof(be_size), &packet);
+    ret = scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    /*then send encoded data, packet index is the block number*/
+    for(i=0; i*MAX_PAYLOAD_SIZE < size; i++)
+    {
+        int block_size = MIN(MAX_PAYLOAD_SIZE, size - i*MAX_PAYLOAD_SIZE);
+        scb_build_packet(PCCOM_SEQ_CTRL, SEQ_CTRL_UPLOAD_SLOT_DATA, i,
+                data + i*MAX_PAYLOAD_SIZE, block_size, &packet);
+        ret = scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+        if(ret < 0)
+        {
+            return ret;
+        }
+    }
+
+    return scb_send_string(dev, PCCOM_SEQ_CTRL, SEQ_CTRL_UPLOAD_SLOT_END, 0, seq_desc);
 }
 
+int scb_download_sequence(openscb_dev dev, uint8_t slot_id, frame_t *frame, uint16_t *nb)
+{
+    int ret;
+    pccomm_packet_t packet;
+    uint16_t first = 0;
+    uint16_t slot_frame_nb;
 
-int scb_upload_sequence_end(openscb_dev dev, const char *seq_desc)
+    /*frame index of a packet is 8 bits, ask frames by pages*/
+    do
+    {
+        uint16_t page = MIN(*nb - first, 0xFF);
+        uint16_t request[2];
+
+        request[0] = BE16(first);
+        request[1] = BE16(page);
+        scb_build_packet(PCCOM_SEQ_CTRL, SEQ_CTRL_DOWNLOAD_SLOT, slot_id, request, sizeof(request), &packet);
+        ret = scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+        if(ret < 0)
+        {
+            return ret;
+        }
+
+        /*get answer (== number of frame in sequence)*/
+        ret = scb_get_reply(dev, &packet, PCCOM_SEQ_CTRL, SEQ_CTRL_DOWNLOAD_SLOT);
+        if(ret < 0)
+        {
+            return ret;
+        }
+        slot_frame_nb = BE16(*((uint16_t*)packet.data));
+        *nb = MIN(*nb, slot_frame_nb);
+        page = MIN(page, *nb - first);
+
+        /*then get the frames of this page*/
+        ret = scb_receive_and_defragment(dev, frame + first, page, sizeof(frame_t),
+                PCCOM_SEQ_CTRL, SEQ_CTRL_DOWNLOAD_SLOT_FRAME);
+        if(ret < 0)
+        {
+            return ret;
+        }
+        first += page;
+    }
+    while(first < *nb);
+
+    return slot_frame_nb;
+}
+
+
+int scb_save_sys_conf(openscb_dev dev)
 {
-    return scb_send_string(dev, PCCOM_SEQ_CTRL, SEQ_CTRL_UPLOAD_SLOT_END, 0, seq_desc);
+    return scb_send_request(dev, PCCOM_SYS_CONF, SAVE_SYS_CONF);
 }
 
 
-int scb_upload_sequence_frame(openscb_dev dev, uint8_t index, uint32_t duration,
-        const float *position, const bool *active, uint8_t nb)
+int scb_load_sys_conf(openscb_dev dev)
 {
-    return scb_send_frame(dev, PCCOM_SEQ_CTRL, SEQ_CTRL_UPLOAD_SLOT_FRAME, index,
-            duration, position, active, nb);
+    return scb_send_request(dev, PCCOM_SYS_CONF, LOAD_SYS_CONF);
 }
 
-int scb_download_sequence(openscb_dev dev, uint8_t slot_id, frame_t *frame, uint8_t *nb)
+
+int scb_get_sys_conf_digest(openscb_dev dev, sys_conf_digest_t *digest)
 {
     int ret;
+    int i;
     pccomm_packet_t packet;
+    sys_conf_digest_t tmp;
 
-    /*send a packet requesting to download slot*/
-    ret = scb_send_request_index(dev, PCCOM_SEQ_CTRL, SEQ_CTRL_DOWNLOAD_SLOT, slot_id);
+    ret = scb_request_and_get_reply(dev, &packet, PCCOM_SYS_CONF, REQ_SYS_CONF_DIGEST, 0);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    memcpy(&tmp, packet.data, sizeof(tmp));
+    digest->all = BE16(tmp.all);
+    for(i=0; i<SYS_CONF_SECTION_NB; i++)
+    {
+        digest->section[i] = BE16(tmp.section[i]);
+    }
 
-    /*get answer (== number of frame in sequence)*/
-    ret = scb_get_reply(dev, &packet, PCCOM_SEQ_CTRL, SEQ_CTRL_DOWNLOAD_SLOT);
+    return 0;
+}
+
+
+uint32_t scb_compare_sys_conf_digest(const sys_conf_digest_t *a,
+        const sys_conf_digest_t *b)
+{
+    int i;
+    uint32_t diff = 0;
+
+    for(i=0; i<SYS_CONF_SECTION_NB; i++)
+    {
+        if(a->section[i] != b->section[i])
+        {
+            diff |= 1 << i;
+        }
+    }
+
+    return diff;
+}
+
+
+int scb_get_sys_conf(openscb_dev dev, sys_conf_image_t *image)
+{
+    int ret;
+    uint8_t blocks[SYS_CONF_IMAGE_BLOCK_NB][SYS_CONF_IMAGE_BLOCK_SIZE];
+
+    ret = scb_request_and_defragment(dev, blocks, SYS_CONF_IMAGE_BLOCK_NB,
+            SYS_CONF_IMAGE_BLOCK_SIZE, PCCOM_SYS_CONF, REQ_SYS_CONF_IMAGE);
     if(ret < 0)
     {
         return ret;
     }
 
-    /*then get all frame in native format*/
-    uint16_t frame_nb = *((uint16_t*)packet.data);
-    frame_nb = BE16(frame_nb);
-    *nb = MIN(*nb, frame_nb);
+    memcpy(image, blocks, sizeof(sys_conf_image_t));
+    if(BE16(image->version) != SYS_CONF_IMAGE_VERSION)
+    {
+        return -1;
+    }
 
-    return scb_receive_and_defragment(dev, frame, *nb, sizeof(frame_t),
-            PCCOM_SEQ_CTRL, SEQ_CTRL_DOWNLOAD_SLOT_FRAME);
+    return 0;
+}
+
+
+int scb_set_sys_conf(openscb_dev dev, const sys_conf_image_t *image)
+{
+    uint8_t blocks[SYS_CONF_IMAGE_BLOCK_NB][SYS_CONF_IMAGE_BLOCK_SIZE];
+
+    memset(blocks, 0, sizeof(blocks));
+    memcpy(blocks, image, sizeof(sys_conf_image_t));
+
+    return scb_fragment_and_send_data(dev, blocks, SYS_CONF_IMAGE_BLOCK_NB,
+            SYS_CONF_IMAGE_BLOCK_SIZE, PCCOM_SYS_CONF, SET_SYS_CONF_IMAGE);
 }
 
 
@@ -187,6 +378,29 @@ int scb_get_flash_overview(openscb_dev dev, slot_header_t *slot_header,
             sizeof(slot_header_t), PCCOM_USER_FLASH, FLASH_REQ_OVERVIEW_ALL);
 }
 
+int scb_find_free_flash_slot(openscb_dev dev)
+{
+    int ret;
+    int i;
+    slot_header_t headers[FLASH_SLOT_NB];
+
+    ret = scb_get_flash_overview(dev, headers, FLASH_SLOT_NB);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    for(i=0; i<FLASH_SLOT_NB; i++)
+    {
+        uint32_t type = BE32(headers[i].type);
+        if(type == SLOT_UNINIT || type == SLOT_EMPTY)
+        {
+            return i;
+        }
+    }
+    return FLASH_SLOT_NB;
+}
+
 
 int scb_set_flash_slot_description(openscb_dev dev, uint8_t slot_id,
         char *description)
@@ -195,3 +409,195 @@ int scb_set_flash_slot_description(openscb_dev dev, uint8_t slot_id,
             slot_id, description);
 }
 
+
+int scb_get_output_latency(openscb_dev dev, latency_stats_t *stats)
+{
+    int ret;
+    pccomm_packet_t packet;
+    latency_stats_t tmp;
+
+    ret = scb_request_and_get_reply(dev, &packet, PCCOM_CORE, REQ_OUTPUT_LATENCY, 0);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    memcpy(&tmp, packet.data, sizeof(tmp));
+    stats->sample_nb = BE32(tmp.sample_nb);
+    stats->min_us = BE32(tmp.min_us);
+    stats->avg_us = BE32(tmp.avg_us);
+    stats->max_us = BE32(tmp.max_us);
+
+    return 0;
+}
+
+
+int scb_reset_output_latency(openscb_dev dev)
+{
+    return scb_send_request(dev, PCCOM_CORE, RESET_OUTPUT_LATENCY);
+}
+
+
+int scb_get_core_timing(openscb_dev dev, core_timing_stats_t *stats)
+{
+    int ret;
+    pccomm_packet_t packet;
+    core_timing_stats_t tmp;
+
+    ret = scb_request_and_get_reply(dev, &packet, PCCOM_CORE, REQ_CORE_TIMING, 0);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    memcpy(&tmp, packet.data, sizeof(tmp));
+    stats->cycle_nb = BE32(tmp.cycle_nb);
+    stats->missed_nb = BE32(tmp.missed_nb);
+    stats->overrun_nb = BE32(tmp.overrun_nb);
+    stats->max_cycle_us = BE32(tmp.max_cycle_us);
+    stats->max_late_ms = BE32(tmp.max_late_ms);
+
+    return 0;
+}
+
+
+int scb_get_stage_timing(openscb_dev dev, uint8_t stage, core_stage_stats_t *stats)
+{
+    int ret;
+    pccomm_packet_t packet;
+    core_stage_stats_t tmp;
+
+    ret = scb_request_and_get_reply(dev, &packet, PCCOM_CORE, REQ_STAGE_TIMING, stage);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    memcpy(&tmp, packet.data, sizeof(tmp));
+    stats->period_ms = BE32(tmp.period_ms);
+    stats->run_nb = BE32(tmp.run_nb);
+    stats->missed_nb = BE32(tmp.missed_nb);
+    stats->overrun_nb = BE32(tmp.overrun_nb);
+    stats->max_run_us = BE32(tmp.max_run_us);
+    stats->max_late_ms = BE32(tmp.max_late_ms);
+
+    return 0;
+}
+
+
+int scb_reset_core_timing(openscb_dev dev)
+{
+    return scb_send_request(dev, PCCOM_CORE, RESET_CORE_TIMING);
+}
+
+
+int scb_set_overrun_policy(openscb_dev dev, uint8_t policy)
+{
+    return scb_send_request_index(dev, PCCOM_CORE, SET_OVERRUN_POLICY, policy);
+}
+
+
+int scb_set_pid_conf(openscb_dev dev, const pid_conf_t *conf, uint8_t nb)
+{
+    return scb_fragment_and_send_data(dev, conf, nb, sizeof(pid_conf_t),
+            PCCOM_PID_CTRL, PID_SET_CONF);
+}
+
+
+int scb_get_pid_conf(openscb_dev dev, pid_conf_t *conf, uint8_t nb)
+{
+    return scb_request_and_defragment(dev, conf, nb, sizeof(pid_conf_t),
+            PCCOM_PID_CTRL, PID_REQ_CONF);
+}
+
+
+int scb_set_pid_setpoint(openscb_dev dev, float *setpoints, uint8_t nb)
+{
+    return scb_send_float_as_dsp16_array(dev, PCCOM_PID_CTRL, PID_SET_SETPOINT,
+            setpoints, nb);
+}
+
+
+int scb_get_pid_setpoint(openscb_dev dev, float *setpoints, uint8_t nb)
+{
+    return scb_request_and_parse_dsp16(dev, setpoints, nb, PCCOM_PID_CTRL,
+            PID_REQ_SETPOINT);
+}
+
+
+int scb_set_pid_enabled(openscb_dev dev, const bool *enabled, uint8_t nb)
+{
+    int pos_nb = MIN(MAX_OUT_NB, nb);
+    pccomm_packet_t packet;
+
+    uint32_t enabled_bm = scb_bool_to_bitmask(enabled, pos_nb);
+
+    scb_build_packet(PCCOM_PID_CTRL, PID_SET_ENABLED_BM, 0, &enabled_bm,
+            sizeof(enabled_bm), &packet);
+
+    return scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+}
+
+
+int scb_set_gait_conf(openscb_dev dev, const gait_conf_t *conf)
+{
+    pccomm_packet_t packet;
+
+    scb_build_packet(PCCOM_GAIT_CTRL, GAIT_SET_CONF, 0, conf, sizeof(gait_conf_t), &packet);
+    return scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+}
+
+
+int scb_get_gait_conf(openscb_dev dev, gait_conf_t *conf)
+{
+    int ret;
+    pccomm_packet_t packet;
+
+    ret = scb_request_and_get_reply(dev, &packet, PCCOM_GAIT_CTRL, GAIT_REQ_CONF, 0);
+    if(ret < 0)
+    {
+        return ret;
+    }
+
+    memcpy(conf, packet.data, sizeof(gait_conf_t));
+    return 0;
+}
+
+
+int scb_set_gait_legs(openscb_dev dev, const gait_leg_t *legs, uint8_t nb)
+{
+    return scb_fragment_and_send_data(dev, legs, MIN(nb, GAIT_LEG_NB), sizeof(gait_leg_t),
+            PCCOM_GAIT_CTRL, GAIT_SET_LEGS);
+}
+
+
+int scb_get_gait_legs(openscb_dev dev, gait_leg_t *legs, uint8_t nb)
+{
+    return scb_request_and_defragment(dev, legs, MIN(nb, GAIT_LEG_NB), sizeof(gait_leg_t),
+            PCCOM_GAIT_CTRL, GAIT_REQ_LEGS);
+}
+
+
+int scb_set_gait_type(openscb_dev dev, uint8_t type)
+{
+    return scb_send_request_index(dev, PCCOM_GAIT_CTRL, GAIT_SET_TYPE, type);
+}
+
+
+int scb_set_gait_motion(openscb_dev dev, float speed, float heading)
+{
+    pccomm_packet_t packet;
+    gait_motion_t motion;
+
+    motion.speed = scb_convert_float_dsp16_BE(speed);
+    motion.heading = scb_convert_float_dsp16_BE(heading);
+
+    scb_build_packet(PCCOM_GAIT_CTRL, GAIT_SET_MOTION, 0, &motion, sizeof(motion), &packet);
+    return scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+}
+
+
+int scb_set_gait_enabled(openscb_dev dev, bool enable)
+{
+    return scb_send_request_index(dev, PCCOM_GAIT_CTRL, GAIT_SET_ENABLED, enable ? 1 : 0);
+}
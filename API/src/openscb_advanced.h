@@ -82,37 +82,30 @@ int scb_set_output_name(openscb_dev dev, io_name_t *names, uint8_t nb);
 
 
 /**
- * Start a sequence store procedure, you then need to add frame
- * one by one using scb_upload_sequence_frame function.
+ * Store a sequence in a flash slot. Frames are sent with the compact
+ * sequence encoding (see openscb_utils.h), the slot is valid only once the
+ * whole sequence has been received by the board.
  *
  * \param dev handle to openscb device
  * \param slot_id in what flash space the sequence will be saved
- * \param frame_nb number of frame that are part of the sequence
- * \return <0 on error
- */
-int scb_upload_sequence_start(openscb_dev dev, uint8_t slot_id, uint16_t frame_nb);
-
-/**
- * Send frame to be save in flash, you should have called
- * scb_upload_sequence_start before this function.
- * When all frame has been send, you can call scb_upload_sequence_end to
- * finish the job.
- *
- * \param dev handle to openscb device
- * \note see scb_load_frame for parameters definition
- * \return <0 on error
+ * \param frames frames of the sequence (board format)
+ * \param frame_nb number of frames in the sequence
+ * \param seq_desc sequence description (might be truncated upon sending)
+ * \return <0 on error, or if the encoded sequence does not fit in a slot
  */
-int scb_upload_sequence_frame(openscb_dev dev, uint8_t index, uint32_t duration,
-        const float *position, const bool *active, uint8_t nb);
+int scb_upload_sequence(openscb_dev dev, uint8_t slot_id, const frame_t *frames,
+        uint16_t frame_nb, const char *seq_desc);
 
 /**
- * Terminate the sequence store procedure.
+ * Get a sequence stored in a flash slot.
  *
  * \param dev handle to openscb device
- * \param seq_desc sequence description (might be truncated upon sending)
- * \return <0 on error
+ * \param slot_id slot to read
+ * \param frame[out] frames of the sequence (board format)
+ * \param nb[in,out] size of frame array, then number of frames read
+ * \return <0 on error, number of frames of the slot otherwise (can be more than nb)
  */
-int scb_upload_sequence_end(openscb_dev dev, const char *seq_desc);
+int scb_download_sequence(openscb_dev dev, uint8_t slot_id, frame_t *frame, uint16_t *nb);
 
 
 /**
@@ -134,6 +127,15 @@ int scb_get_flash_slot(openscb_dev dev, uint8_t slot_id, slot_header_t *slot_hea
  */
 int scb_get_flash_overview(openscb_dev dev, slot_header_t *slot_header, uint8_t nb);
 
+/**
+ * Find a flash slot that can be written without losing data
+ * (slot is uninitialized or empty).
+ *
+ * \param dev handle to openscb device
+ * \return <0 on error, FLASH_SLOT_NB if all slots are used, else first free slot
+ */
+int scb_find_free_flash_slot(openscb_dev dev);
+
 
 /**
  * Get current input calibration
@@ -166,6 +168,27 @@ int scb_get_out_calib_values(openscb_dev dev, output_calib_data_t *calib, uint8_
  */
 int scb_set_out_calib_values(openscb_dev dev, output_calib_data_t *calib,
         uint8_t nb);
+
+/**
+ * Get output calibration tables
+ *
+ * \param dev handle to openscb device
+ * \param lut[out] list of output calibration tables
+ * \param nb number of tables to get from the board
+ * \return <0 on error
+ */
+int scb_get_out_lut(openscb_dev dev, output_lut_t *lut, uint8_t nb);
+
+/**
+ * Set output calibration tables, outputs with an enabled table
+ * use it instead of the linear calibration.
+ *
+ * \param dev handle to openscb device
+ * \param lut list of output calibration tables
+ * \param nb number of tables in lut array
+ * \return <0 on error
+ */
+int scb_set_out_lut(openscb_dev dev, output_lut_t *lut, uint8_t nb);
 /**
  * Set raw value on one output (used for calibration)
  *
@@ -176,6 +199,29 @@ int scb_set_out_calib_values(openscb_dev dev, output_calib_data_t *calib,
  */
 int scb_set_out_calib_raw(openscb_dev dev, uint8_t out_id, _dsp16_t value);
 
+/**
+ * Start/stop streaming of raw input values, the board then sends one
+ * sample per core cycle on the master endpoint while in input calibration mode.
+ *
+ * \param dev handle to openscb device
+ * \param enable true to start streaming
+ * \return <0 on error
+ */
+int scb_set_input_stream(openscb_dev dev, bool enable);
+
+/**
+ * Read one message from the master endpoint and decode it if it is an
+ * input sample. Trace messages read by this function are lost.
+ *
+ * \param dev handle to openscb device
+ * \param sample[out] received sample (native format)
+ * \param timeout maximum time to wait for a message in ms
+ * \return 1 if a sample was received, 0 if the message was something else,
+ *  <0 on error
+ */
+int scb_get_input_stream_sample(openscb_dev dev, input_stream_sample_t *sample,
+        int timeout);
+
 /**
  * Force the board to restart into bootloader mode
  *
@@ -193,6 +239,235 @@ int scb_req_restart_to_bootloader(openscb_dev dev);
  */
 int scb_save_sys_conf(openscb_dev dev);
 
+/**
+ * Restore last saved system configuration, unsaved changes are lost
+ *
+ * \param dev handle to openscb device
+ * \return <0 on error
+ */
+int scb_load_sys_conf(openscb_dev dev);
+
+
+/**
+ * Get digest of the board system configuration
+ *
+ * \param dev handle to openscb device
+ * \param digest[out] digest of the board configuration
+ * \return <0 on error
+ */
+int scb_get_sys_conf_digest(openscb_dev dev, sys_conf_digest_t *digest);
+
+/**
+ * Compare two configuration digests, typically the one of the board and
+ * one computed with scb_compute_sys_conf_digest from the configuration
+ * the PC wants to apply. Only differing sections need to be sent.
+ *
+ * \param a first digest
+ * \param b second digest
+ * \return bitmask of differing sections (1 << SYS_CONF_SECTION_xxx)
+ */
+uint32_t scb_compare_sys_conf_digest(const sys_conf_digest_t *a,
+        const sys_conf_digest_t *b);
+
+
+/**
+ * Get the whole system configuration in one transfer
+ *
+ * \param dev handle to openscb device
+ * \param image[out] board configuration (board format)
+ * \return <0 on error or if the board use another configuration version
+ */
+int scb_get_sys_conf(openscb_dev dev, sys_conf_image_t *image);
+
+/**
+ * Set the whole system configuration in one transfer, the board applies
+ * it only once all data are received.
+ *
+ * \param dev handle to openscb device
+ * \param image new configuration (board format), version must be
+ *  SYS_CONF_IMAGE_VERSION
+ * \return <0 on error
+ */
+int scb_set_sys_conf(openscb_dev dev, const sys_conf_image_t *image);
+
+
+/**
+ * Get latency statistics between the time output values are produced
+ * (received from PC or computed by a controller) and the first servo pulse
+ * generated with these values.
+ *
+ * \param dev handle to openscb device
+ * \param stats[out] latency statistics (in microseconds)
+ * \return <0 on error
+ */
+int scb_get_output_latency(openscb_dev dev, latency_stats_t *stats);
+
+/**
+ * Restart latency statistics from scratch
+ *
+ * \param dev handle to openscb device
+ * \return <0 on error
+ */
+int scb_reset_output_latency(openscb_dev dev);
+
+
+/**
+ * Get core task timing statistics (missed periods, cycle time)
+ *
+ * \param dev handle to openscb device
+ * \param stats[out] core timing statistics
+ * \return <0 on error
+ */
+int scb_get_core_timing(openscb_dev dev, core_timing_stats_t *stats);
+
+/**
+ * Get timing statistics of one stage of the core task (missed periods,
+ * execution time). Stage 0 is the main input/output stage.
+ *
+ * \param dev handle to openscb device
+ * \param stage stage number, up to CORE_STAGE_MAX_NB
+ * \param stats[out] stage timing statistics, period_ms is 0 if stage does not exist
+ * \return <0 on error
+ */
+int scb_get_stage_timing(openscb_dev dev, uint8_t stage, core_stage_stats_t *stats);
+
+/**
+ * Restart core task timing statistics (task and stages) from scratch
+ *
+ * \param dev handle to openscb device
+ * \return <0 on error
+ */
+int scb_reset_core_timing(openscb_dev dev);
+
+/**
+ * Choose what the core task does when it misses some periods
+ *
+ * \param dev handle to openscb device
+ * \param policy one of OVERRUN_POLICY values
+ * \return <0 on error
+ */
+int scb_set_overrun_policy(openscb_dev dev, uint8_t policy);
+
+
+/**
+ * Set configuration (gains, feedback input) of on board PID loops
+ *
+ * \param dev handle to openscb device
+ * \param conf list of PID configuration, one per output (board format)
+ * \param nb number of configuration structure in conf array
+ * \return <0 on error
+ */
+int scb_set_pid_conf(openscb_dev dev, const pid_conf_t *conf, uint8_t nb);
+
+/**
+ * Get configuration of on board PID loops
+ *
+ * \param dev handle to openscb device
+ * \param conf[out] list of PID configuration, one per output (board format)
+ * \param nb number of configuration structure to get from the board
+ * \return <0 on error
+ */
+int scb_get_pid_conf(openscb_dev dev, pid_conf_t *conf, uint8_t nb);
+
+/**
+ * Set the value each PID loop should reach on its feedback input
+ *
+ * \param dev handle to openscb device
+ * \param setpoints list of setpoints [-1.0 .. 1.0], one per output
+ * \param nb size of setpoints array
+ * \return <0 on error
+ */
+int scb_set_pid_setpoint(openscb_dev dev, float *setpoints, uint8_t nb);
+
+/**
+ * Get current setpoint of each PID loop
+ *
+ * \param dev handle to openscb device
+ * \param setpoints[out] list of setpoints, one per output
+ * \param nb size of setpoints array
+ * \return <0 on error
+ */
+int scb_get_pid_setpoint(openscb_dev dev, float *setpoints, uint8_t nb);
+
+/**
+ * Choose which outputs are driven by their PID loop
+ *
+ * \param dev handle to openscb device
+ * \param enabled true for each output controlled by its PID loop
+ * \param nb size of enabled array
+ * \return <0 on error
+ */
+int scb_set_pid_enabled(openscb_dev dev, const bool *enabled, uint8_t nb);
+
+
+/**
+ * Set step shape (cycle period, stride, lift) of on board gait controller
+ *
+ * \param dev handle to openscb device
+ * \param conf gait configuration (board format), period can't be 0
+ * \return <0 on error
+ */
+int scb_set_gait_conf(openscb_dev dev, const gait_conf_t *conf);
+
+/**
+ * Get step shape of on board gait controller
+ *
+ * \param dev handle to openscb device
+ * \param conf[out] gait configuration (board format)
+ * \return <0 on error
+ */
+int scb_get_gait_conf(openscb_dev dev, gait_conf_t *conf);
+
+/**
+ * Set outputs and ground position of the legs driven by the gait controller
+ *
+ * \param dev handle to openscb device
+ * \param legs list of legs configuration (board format), see GAIT_LEG_NB for legs order
+ * \param nb number of legs in legs array
+ * \return <0 on error
+ */
+int scb_set_gait_legs(openscb_dev dev, const gait_leg_t *legs, uint8_t nb);
+
+/**
+ * Get legs configuration of the gait controller
+ *
+ * \param dev handle to openscb device
+ * \param legs[out] list of legs configuration (board format)
+ * \param nb number of legs to get from the board
+ * \return <0 on error
+ */
+int scb_get_gait_legs(openscb_dev dev, gait_leg_t *legs, uint8_t nb);
+
+/**
+ * Choose the gait used by the gait controller
+ *
+ * \param dev handle to openscb device
+ * \param type one of GAIT_TRIPOD, GAIT_RIPPLE or GAIT_WAVE
+ * \return <0 on error
+ */
+int scb_set_gait_type(openscb_dev dev, uint8_t type);
+
+/**
+ * Set walking speed and heading of the gait controller, the robot stands
+ * still when both are 0.
+ *
+ * \param dev handle to openscb device
+ * \param speed [-1.0 .. 1.0], 1.0 does one gait cycle per period
+ * \param heading [-1.0 .. 1.0], positive to turn right
+ * \return <0 on error
+ */
+int scb_set_gait_motion(openscb_dev dev, float speed, float heading);
+
+/**
+ * Start or stop the gait controller, legs outputs are driven by the gait
+ * controller while it is enabled.
+ *
+ * \param dev handle to openscb device
+ * \param enable true to start the gait controller
+ * \return <0 on error
+ */
+int scb_set_gait_enabled(openscb_dev dev, bool enable);
+
 
 #ifdef __cplusplus
 }
@@ -48,6 +48,15 @@ int scb_get_pure_raw_message(openscb_dev dev, pccomm_packet_t *packet, int timeo
  */
 int scb_send_pure_raw_message(openscb_dev dev, pccomm_packet_t *packet, int timeout);
 
+
+/**
+ * Read data sent by the board on the master endpoint: trace text, or
+ * packets with PCCOM_MASTER_PACKET_FLAG set in their module id.
+ *
+ * \return the number of byte actually received, or negative number on error/timeout
+ */
+int scb_get_debug_message(openscb_dev dev, char *data, int size, int timeout);
+
 #ifdef __cplusplus
 }
 #endif
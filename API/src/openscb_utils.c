@@ -56,20 +56,26 @@ int scb_send_float_as_dsp16_array(openscb_dev dev,
 int scb_send_frame(openscb_dev dev, uint8_t module, uint8_t command, uint8_t index,
     uint32_t duration, const float *position, const bool *active, uint8_t nb)
 {
-    int pos_nb = MIN(MAX_OUT_NB, nb);
-
     pccomm_packet_t packet;
     packet.header.module = module;
     packet.header.command = command;
     packet.header.index = index;
     packet.header.size = sizeof(pccomm_msg_header_t) + sizeof(frame_t);
 
-    frame_t *frame = (frame_t*)packet.data;
+    scb_build_frame((frame_t*)packet.data, duration, position, active, nb);
+
+    return scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
+}
+
+
+void scb_build_frame(frame_t *frame, uint32_t duration, const float *position,
+    const bool *active, uint8_t nb)
+{
+    int pos_nb = MIN(MAX_OUT_NB, nb);
+
     frame->active_bm = scb_bool_to_bitmask(active, pos_nb);
     frame->duration = BE32(duration);
     scb_convert_float_dsp16_BE_array(position, frame->position, pos_nb);
-
-    return scb_send_pure_raw_message(dev, &packet, DEFAULT_TIMEOUT);
 }
 
 
@@ -402,3 +408,186 @@ void scb_convert_dsp16_BE_float_array(const _dsp16_t *x, float *res, int size)
         res[i] = RCVALUE_TO_FLOAT(BE16(x[i]));
     }
 }
+
+//! helper function: write an unsigned varint, return its size or -1
+static int varint_write(uint32_t value, uint8_t *out, int size)
+{
+    int n = 0;
+
+    do
+    {
+        if(n >= size)
+        {
+            return -1;
+        }
+        out[n] = value & 0x7F;
+        value >>= 7;
+        if(value != 0)
+        {
+            out[n] |= 0x80;
+        }
+        n++;
+    } while(value != 0);
+
+    return n;
+}
+
+//! helper function: read an unsigned varint, return its size or -1
+static int varint_read(const uint8_t *in, int size, uint32_t *value)
+{
+    int n = 0;
+
+    *value = 0;
+    do
+    {
+        if(n >= size || n >= 5)
+        {
+            return -1;
+        }
+        *value |= (uint32_t)(in[n] & 0x7F) << (7*n);
+    } while(in[n++] & 0x80);
+
+    return n;
+}
+
+//see header
+void scb_seq_codec_init(scb_seq_codec_t *codec)
+{
+    memset(codec, 0, sizeof(scb_seq_codec_t));
+}
+
+//see header
+int scb_seq_encode_frame(scb_seq_codec_t *codec, const frame_t *frame,
+        uint8_t *out, int size)
+{
+    uint32_t active_bm = BE32(frame->active_bm);
+    int pos = 0;
+    int ret;
+    int i;
+
+    ret = varint_write(BE32(frame->duration), out, size);
+    if(ret < 0)
+    {
+        return ret;
+    }
+    pos += ret;
+
+    ret = varint_write(active_bm, out + pos, size - pos);
+    if(ret < 0)
+    {
+        return ret;
+    }
+    pos += ret;
+
+    for(i=0; i<MAX_OUT_NB; i++)
+    {
+        if(active_bm & (1 << i))
+        {
+            _dsp16_t value = BE16(frame->position[i]);
+            int16_t delta = (int16_t)(value - codec->position[i]);
+            uint16_t zigzag = (delta << 1) ^ (delta >> 15);
+
+            ret = varint_write(zigzag, out + pos, size - pos);
+            if(ret < 0)
+            {
+                return ret;
+            }
+            pos += ret;
+            codec->position[i] = value;
+        }
+    }
+
+    return pos;
+}
+
+//see header
+int scb_seq_decode_frame(scb_seq_codec_t *codec, const uint8_t *in, int size,
+        frame_t *frame)
+{
+    uint32_t duration;
+    uint32_t active_bm;
+    uint32_t zigzag;
+    int pos = 0;
+    int ret;
+    int i;
+
+    ret = varint_read(in, size, &duration);
+    if(ret < 0)
+    {
+        return ret;
+    }
+    pos += ret;
+
+    ret = varint_read(in + pos, size - pos, &active_bm);
+    if(ret < 0)
+    {
+        return ret;
+    }
+    pos += ret;
+
+    for(i=0; i<MAX_OUT_NB; i++)
+    {
+        if(active_bm & (1 << i))
+        {
+            ret = varint_read(in + pos, size - pos, &zigzag);
+            if(ret < 0 || zigzag > 0xFFFF)
+            {
+                return -1;
+            }
+            pos += ret;
+            codec->position[i] += (int16_t)((zigzag >> 1) ^ -(zigzag & 1));
+        }
+        frame->position[i] = BE16(codec->position[i]);
+    }
+
+    frame->duration = BE32(duration);
+    frame->active_bm = BE32(active_bm);
+    return pos;
+}
+
+
+//see header
+uint16_t scb_crc16(uint16_t crc, const void *data, int size)
+{
+    const uint8_t *d = data;
+    int i;
+
+    //bitwise version, slower but doesn't waste board flash with a table
+    while(size > 0)
+    {
+        crc ^= (uint16_t)(*d) << 8;
+        for(i=0; i<8; i++)
+        {
+            if(crc & 0x8000)
+                crc = (crc << 1) ^ 0x1021;
+            else
+                crc = crc << 1;
+        }
+        d++;
+        size--;
+    }
+
+    return crc;
+}
+
+//see header
+void scb_compute_sys_conf_digest(const input_conf_t *in_conf,
+        const output_conf_t *out_conf, const output_lut_t *out_lut,
+        uint32_t active_bm, sys_conf_digest_t *digest)
+{
+    const int in_size = MAX_IN_NB*sizeof(input_conf_t);
+    const int out_size = MAX_OUT_NB*sizeof(output_conf_t);
+    const int lut_size = MAX_OUT_NB*sizeof(output_lut_t);
+    uint16_t all;
+
+    digest->section[SYS_CONF_SECTION_INPUT] = scb_crc16(SCB_CRC16_INIT, in_conf, in_size);
+    digest->section[SYS_CONF_SECTION_OUTPUT] = scb_crc16(SCB_CRC16_INIT, out_conf, out_size);
+    digest->section[SYS_CONF_SECTION_ACTIVE_BM] = scb_crc16(SCB_CRC16_INIT,
+            &active_bm, sizeof(active_bm));
+    digest->section[SYS_CONF_SECTION_OUTPUT_LUT] = scb_crc16(SCB_CRC16_INIT, out_lut, lut_size);
+
+    all = scb_crc16(SCB_CRC16_INIT, in_conf, in_size);
+    all = scb_crc16(all, out_conf, out_size);
+    all = scb_crc16(all, &active_bm, sizeof(active_bm));
+    digest->all = scb_crc16(all, out_lut, lut_size);
+}
@@ -47,6 +47,10 @@ int scb_send_string(openscb_dev dev, uint8_t module, uint8_t command,
 int scb_send_frame(openscb_dev dev, uint8_t module, uint8_t command, uint8_t index,
     uint32_t duration, const float *position, const bool *active, uint8_t nb);
 
+/*fill a frame in board format*/
+void scb_build_frame(frame_t *frame, uint32_t duration, const float *position,
+    const bool *active, uint8_t nb);
+
 /*generate control bitfield expected by the board*/
 uint32_t scb_bool_to_bitmask(const bool *active, uint8_t nb);
 
@@ -138,6 +142,89 @@ void scb_convert_float_dsp16_BE_array(const float *x, _dsp16_t *res, int size);
  */
 void scb_convert_dsp16_BE_float_array(const _dsp16_t *x, float *res, int size);
 
+/**
+ * Compute a CRC16 (CCITT polynomial) of a block of data.
+ * This is shared by the board and the PC to check data integrity.
+ *
+ * \param crc initial value (SCB_CRC16_INIT), or result of a previous call
+ *  to compute the CRC of several blocks
+ * \param data data to check
+ * \param size data size in bytes
+ * \return updated CRC value
+ */
+uint16_t scb_crc16(uint16_t crc, const void *data, int size);
+
+//! initial value to use with scb_crc16
+#define SCB_CRC16_INIT      0xFFFF
+
+/**
+ * Compute digest of a system configuration.
+ * This is shared by the board and the PC, so both compute the same values.
+ *
+ * \param in_conf configuration of MAX_IN_NB inputs (board format)
+ * \param out_conf configuration of MAX_OUT_NB outputs (board format)
+ * \param out_lut calibration tables of MAX_OUT_NB outputs (board format)
+ * \param active_bm enabled outputs bitmask (board format)
+ * \param[out] digest result (native format)
+ */
+void scb_compute_sys_conf_digest(const input_conf_t *in_conf,
+        const output_conf_t *out_conf, const output_lut_t *out_lut,
+        uint32_t active_bm, sys_conf_digest_t *digest);
+
+
+/**
+ * \name Compact sequence encoding
+ * Encoded sequences start with the number of frames (big endian uint16),
+ * followed by each frame:
+ *  - duration, unsigned varint
+ *  - active bitmask, unsigned varint
+ *  - for each active output: position difference with the last position of
+ *    this output in the sequence (0 at start), 16 bits wrapping, zigzag varint
+ *
+ * Varints are 7 bits per byte, least significant first, bit 7 set when more
+ * bytes follow. This is shared by the board and the PC.
+ */
+/// @{
+
+//! size of the header of an encoded sequence
+#define SCB_SEQ_HEADER_SIZE         2
+//! maximum encoded size of one frame
+#define SCB_SEQ_FRAME_MAX_SIZE      (5 + 5 + 3*MAX_OUT_NB)
+
+//! state of a sequence encoder or decoder
+typedef struct {
+    _dsp16_t position[MAX_OUT_NB];  //!< last position of each output (native format)
+} scb_seq_codec_t;
+
+/**
+ * Reset codec state, to be done at the beginning of a sequence.
+ */
+void scb_seq_codec_init(scb_seq_codec_t *codec);
+
+/**
+ * Encode one frame.
+ *
+ * \param frame frame to encode (board format)
+ * \param[out] out encoded data
+ * \param size size available in out
+ * \return number of bytes written, <0 if out is too small
+ */
+int scb_seq_encode_frame(scb_seq_codec_t *codec, const frame_t *frame,
+        uint8_t *out, int size);
+
+/**
+ * Decode one frame. Positions of inactive outputs are the last known ones.
+ *
+ * \param in encoded data
+ * \param size size of data available in in
+ * \param[out] frame decoded frame (board format)
+ * \return number of bytes read, <0 if data is truncated or invalid
+ */
+int scb_seq_decode_frame(scb_seq_codec_t *codec, const uint8_t *in, int size,
+        frame_t *frame);
+
+/// @}
+
 #ifdef __cplusplus
 }
 #endif
@@ -59,6 +59,10 @@ extern "C" {
 #define MAX_PACKET_SIZE     64
 #define MAX_PAYLOAD_SIZE    (MAX_PACKET_SIZE-sizeof(pccomm_msg_header_t))
 
+//! Packets sent on the master endpoint have this bit set in their module id,
+//! trace text is 7 bits ASCII so both can share the endpoint
+#define PCCOM_MASTER_PACKET_FLAG    0x80
+
 //! \}
 
 /**
@@ -177,6 +181,261 @@ __attribute__((packed))
     _dsp16_t subtrim;       ///< user middle origin
 } output_calib_data_t;
 
+//! number of points of an output calibration table
+#define OUTPUT_LUT_POINT_NB     9
+//! rc values between two points of an output calibration table (2^OUTPUT_LUT_SHIFT)
+#define OUTPUT_LUT_SHIFT        13
+
+/**
+ * Piecewise linear calibration table for nonlinear outputs.
+ * point[k] is the raw value for the rc value -1.0 + k*2/(OUTPUT_LUT_POINT_NB-1),
+ * values in between are linearly interpolated. Result is still limited
+ * to the output calibration min/max.
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint8_t enabled;        ///< use the table instead of angle_180/subtrim
+    uint8_t reserved;
+    _dsp16_t point[OUTPUT_LUT_POINT_NB];
+} output_lut_t;
+
+/**
+ * Raw values of all inputs, streamed by the board on the master endpoint
+ * during input calibration
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint16_t cycle;             ///< core cycle counter, a gap means samples were lost
+    uint16_t active_bm;         ///< inputs with a valid value
+    _dsp16_t raw[MAX_IN_NB];    ///< raw value of each logical input
+} input_stream_sample_t;
+
+/**
+ * Sent by the board on the master endpoint when outputs reach their goal
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint32_t reached_bm;        ///< outputs that reached their goal since the last notification
+    uint32_t moving_bm;         ///< active outputs still away from their goal
+} goal_reached_notification_t;
+
+/// @}
+
+
+/** \name System configuration type definitions */
+/// @{
+/**
+ * Configuration of one input
+ * Size is kept a multiple of 4 bytes, so arrays of configuration
+ * keep all members aligned.
+ */
+typedef struct
+__attribute__((packed))
+{
+    input_calib_data_t calib;
+    char name[IO_NAME_LEN];
+    uint8_t mapping;            ///< logical input => physical input
+    uint8_t reserved;
+} input_conf_t;
+
+/**
+ * Configuration of one output
+ * Size is kept a multiple of 4 bytes, so arrays of configuration
+ * keep all members aligned.
+ */
+typedef struct
+__attribute__((packed))
+{
+    output_calib_data_t calib;
+    char name[IO_NAME_LEN];
+    uint16_t max_speed;         ///< maximum speed in degrees/s, 0 if not limited
+    uint16_t max_accel;         ///< maximum acceleration in degrees/s^2, 0 if not limited
+    uint32_t max_jerk;          ///< maximum jerk in degrees/s^3 (needs max_accel), 0 if not limited
+} output_conf_t;
+
+/**
+ * Sections of the system configuration that have their own digest
+ */
+typedef enum {
+    SYS_CONF_SECTION_INPUT,         ///< configuration of all inputs
+    SYS_CONF_SECTION_OUTPUT,        ///< configuration of all outputs
+    SYS_CONF_SECTION_ACTIVE_BM,     ///< enabled outputs bitmask
+    SYS_CONF_SECTION_OUTPUT_LUT,    ///< calibration tables of all outputs
+
+    SYS_CONF_SECTION_NB
+} SYS_CONF_SECTION;
+
+/**
+ * CRC16 of the system configuration, it can be used to check if the board
+ * configuration changed without downloading it.
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint16_t all;                               ///< whole configuration
+    uint16_t section[SYS_CONF_SECTION_NB];      ///< each section
+} sys_conf_digest_t;
+
+//! version of sys_conf_image_t, change it each time the structure changes
+#define SYS_CONF_IMAGE_VERSION      3
+
+/**
+ * Whole system configuration, exchanged in one transfer.
+ * All values are stored in big endian (board format).
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint16_t version;                   ///< SYS_CONF_IMAGE_VERSION
+    uint8_t input_nb;
+    uint8_t output_nb;
+    uint32_t servo_active_bm;
+    input_conf_t in_conf[MAX_IN_NB];
+    output_conf_t out_conf[MAX_OUT_NB];
+    output_lut_t out_lut[MAX_OUT_NB];
+} sys_conf_image_t;
+
+//! configuration image is sent in blocks of this size (packet index is the block number)
+#define SYS_CONF_IMAGE_BLOCK_SIZE   MAX_PAYLOAD_SIZE
+#define SYS_CONF_IMAGE_BLOCK_NB     ((sizeof(sys_conf_image_t)+SYS_CONF_IMAGE_BLOCK_SIZE-1) \
+                                        / SYS_CONF_IMAGE_BLOCK_SIZE)
+
+/// @}
+
+
+/** \name Diagnostic type definitions */
+/// @{
+/**
+ * Latency between the time some data are received by the board
+ * (input edge, goal packet, ...) and the first output pulse using them.
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint32_t sample_nb;     ///< number of measured latencies
+    uint32_t min_us;        ///< minimum latency in microseconds
+    uint32_t avg_us;        ///< average latency in microseconds
+    uint32_t max_us;        ///< maximum latency in microseconds
+} latency_stats_t;
+
+/**
+ * What a core task stage does when it could not keep up with its period
+ */
+typedef enum {
+    OVERRUN_CATCH_UP,       ///< run all missed cycles back to back
+    OVERRUN_SKIP,           ///< forget missed cycles and wait for next period
+} OVERRUN_POLICY;
+
+/**
+ * Maximum number of stages run by the core task, each one with its own period
+ */
+#define CORE_STAGE_MAX_NB   8
+
+/**
+ * Core task timing statistics, summed over all stages
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint32_t cycle_nb;      ///< number of core task wake ups
+    uint32_t missed_nb;     ///< number of stage periods missed because of overruns
+    uint32_t overrun_nb;    ///< number of stage executions that lasted more than their period
+    uint32_t max_cycle_us;  ///< longest wake up (all due stages) in microseconds
+    uint32_t max_late_ms;   ///< worst delay between a stage deadline and its execution
+} core_timing_stats_t;
+
+/**
+ * Timing statistics of one core task stage
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint32_t period_ms;     ///< execution period, 0 if the stage does not exist
+    uint32_t run_nb;        ///< number of executions
+    uint32_t missed_nb;     ///< number of periods missed because of overruns
+    uint32_t overrun_nb;    ///< number of executions that lasted more than one period
+    uint32_t max_run_us;    ///< longest execution time in microseconds
+    uint32_t max_late_ms;   ///< worst delay between deadline and execution
+} core_stage_stats_t;
+
+/// @}
+
+
+/** \name Controller type definitions */
+/// @{
+/**
+ * Configuration of one on board PID loop.
+ * Output is (kp*error + integral + kd*d(feedback)) * 2^gain_shift
+ * with integral = sum(ki*error), limited to [-i_limit .. i_limit].
+ */
+typedef struct
+__attribute__((packed))
+{
+    _dsp16_t kp;            ///< proportional gain
+    _dsp16_t ki;            ///< integral gain (per core period)
+    _dsp16_t kd;            ///< derivative gain (per core period)
+    _dsp16_t i_limit;       ///< anti windup, maximum absolute value of integral term
+    uint8_t gain_shift;     ///< all gains are multiplied by 2^gain_shift
+    uint8_t feedback;       ///< input used as feedback
+} pid_conf_t;
+
+/**
+ * Number of legs driven by the gait controller. Legs are numbered from front
+ * to rear on the left side, then from front to rear on the right side.
+ */
+#define GAIT_LEG_NB     6
+
+/**
+ * Gaits of the gait controller, from the fastest to the most stable
+ */
+enum {
+    GAIT_TRIPOD,            ///< 3 legs raised at a time, alternating tripods
+    GAIT_RIPPLE,            ///< 2 legs raised at a time, one on each side
+    GAIT_WAVE,              ///< 1 leg raised at a time, from rear to front on each side
+
+    GAIT_TYPE_NB
+};
+
+/**
+ * Outputs and ground position of one leg of the gait controller
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint8_t coxa;           ///< output moving the leg forward/backward, MAX_OUT_NB if unused
+    uint8_t femur;          ///< output raising the leg, MAX_OUT_NB if unused
+    uint8_t tibia;          ///< output of the lower joint, MAX_OUT_NB if unused
+    int8_t side;            ///< 1 or -1, reverses strokes and lifts for mirrored servos
+    _dsp16_t coxa_center;   ///< coxa position in the middle of the stroke
+    _dsp16_t femur_ground;  ///< femur position with the foot on the ground
+    _dsp16_t tibia_ground;  ///< tibia position with the foot on the ground
+} gait_leg_t;
+
+/**
+ * Step shape of the gait controller, shared by all legs
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint16_t period;        ///< duration of a gait cycle at full speed (ms)
+    _dsp16_t stride;        ///< coxa offset at both ends of the stroke
+    _dsp16_t lift;          ///< femur offset at the top of a step
+    _dsp16_t tuck;          ///< tibia offset at the top of a step
+} gait_conf_t;
+
+/**
+ * Walking command of the gait controller
+ */
+typedef struct
+__attribute__((packed))
+{
+    _dsp16_t speed;         ///< [-1..1], negative to walk backward
+    _dsp16_t heading;       ///< [-1..1], positive to turn right
+} gait_motion_t;
+
 /// @}
 
 
@@ -193,6 +452,52 @@ __attribute__((packed))
     _dsp16_t position[MAX_OUT_NB];
 } frame_t;
 
+/**
+ * Frame starting at a given board time, see REQ_BOARD_TIME
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint32_t start_time;    ///< board time in ms the frame starts at
+    frame_t frame;
+} frame_at_t;
+
+/**
+ * Interpolation between frames
+ */
+enum {
+    FRAME_INTERP_LINEAR,    ///< constant speed from one frame to the next one
+    FRAME_INTERP_CUBIC,     ///< Catmull-Rom spline, continuous speed across queued frames
+
+    FRAME_INTERP_NB
+};
+
+/**
+ * Number of frames that can be queued on the board, must be a power of 2
+ */
+#define FRAME_QUEUE_SIZE    8
+
+/**
+ * Reply to a frame queue request
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint8_t queued;         ///< 1 if the frame has been queued, 0 if the queue was full
+    uint8_t free;           ///< number of free slots remaining in the queue
+} frame_queue_status_t;
+
+/**
+ * Sent by the board on the master endpoint when frames are completed
+ */
+typedef struct
+__attribute__((packed))
+{
+    uint8_t done;           ///< number of frames completed since the last notification
+    uint8_t free;           ///< number of free slots in the queue
+    uint8_t idle;           ///< 1 if the last frame is reached and no frame is queued
+} frame_done_notification_t;
+
 /// @}
 
 
@@ -211,16 +516,22 @@ typedef enum {
     SLOT_IN_SEQUENCE = 0x49534551,  //'ISEQ', virtual input sequence
 } SLOT_TYPE;
 
-#define SLOT_DESC_SIZE  52
+#define SLOT_DESC_SIZE  50
+
+//! number of user flash slots on the board
+#define FLASH_SLOT_NB   8
+//! data size available in one slot (4kB slots, the last 512 bytes keep descriptions)
+#define FLASH_SLOT_DATA_SIZE    (0x1000 - 0x200 - sizeof(slot_header_t))
 
-/*The whole slot has to fit in a 4kB flash page*/
+/*The whole slot has to fit in a 4kB flash page, header fits in one packet*/
 typedef struct
 __attribute__((packed))
 {
     uint32_t type;
     char description[SLOT_DESC_SIZE];
 
-    uint32_t size;
+    uint16_t crc;           ///< CRC16 of type, description, size and slot data
+    uint32_t size;          ///< size of slot data
 } slot_header_t;
 
 /// @}
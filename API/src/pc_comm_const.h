@@ -47,6 +47,9 @@ typedef enum {
 
     PCCOM_USER_FLASH,
 
+    PCCOM_PID_CTRL,
+    PCCOM_GAIT_CTRL,
+
     PCCOM_MODULE_NB
 } PCCOM_MODULE;
 
@@ -60,6 +63,8 @@ enum {
 enum {
     RESTART_BOOTLOADER,
     REQ_SOFT_VERSION,
+
+    REQ_BOARD_TIME,                 //!< board time in ms, frame start times use it
 };
 
 enum {
@@ -73,11 +78,26 @@ enum {
 
     REQ_INPUT_ACTIVE,
     REQ_OUTPUT_ACTIVE,
+
+    REQ_OUTPUT_LATENCY,
+    RESET_OUTPUT_LATENCY,
+
+    REQ_CORE_TIMING,
+    RESET_CORE_TIMING,
+    SET_OVERRUN_POLICY,
+
+    SET_GOAL_NOTIFICATION,          //!< index is 1 to enable, data is the tolerance
+    GOAL_REACHED_NOTIFICATION,      //!< sent by the board on the master endpoint
+
+    REQ_STAGE_TIMING,               //!< index is the stage number
 };
 
 enum {
     SET_OUTPUT_CALIB_RAW,
     SET_INPUT_CALIB_CENTER,
+
+    SET_INPUT_CALIB_STREAM,         //!< index is 1 to enable streaming, 0 to stop
+    INPUT_CALIB_STREAM_SAMPLE,      //!< sent by the board on the master endpoint
 };
 
 enum {
@@ -110,6 +130,20 @@ enum {
 
     SET_INPUT_CALIB_VALUE,
     SET_OUTPUT_CALIB_VALUE,
+
+    REQ_SYS_CONF_DIGEST,
+
+    REQ_SYS_CONF_IMAGE,
+    SET_SYS_CONF_IMAGE,
+
+    REQ_OUTPUT_LUT,
+    SET_OUTPUT_LUT,
+
+    SET_OUTPUT_MAX_ACCEL,
+    REQ_OUTPUT_MAX_ACCEL,
+
+    SET_OUTPUT_MAX_JERK,
+    REQ_OUTPUT_MAX_JERK,
 };
 
 enum {
@@ -130,20 +164,55 @@ enum {
 };
 #endif
 
+enum {
+    PID_SET_CONF,
+    PID_REQ_CONF,
+
+    PID_SET_SETPOINT,
+    PID_REQ_SETPOINT,
+
+    PID_SET_ENABLED_BM,
+    PID_REQ_ENABLED_BM,
+};
+
+enum {
+    GAIT_SET_CONF,
+    GAIT_REQ_CONF,
+
+    GAIT_SET_LEGS,
+    GAIT_REQ_LEGS,
+
+    GAIT_SET_TYPE,                  //!< index is the gait type
+    GAIT_SET_MOTION,                //!< data is a gait_motion_t
+    GAIT_SET_ENABLED,               //!< index is 1 to enable, 0 to disable
+};
+
 enum {
     POS_CTRL_LOAD_FRAME,
     POS_CTRL_DISABLE,
+
+    POS_CTRL_QUEUE_FRAME,
+    POS_CTRL_REQ_QUEUE_STATUS,
+
+    POS_CTRL_SET_INTERPOLATION,
+
+    POS_CTRL_SET_NOTIFICATION,          //!< index is 1 to enable, 0 to disable
+    POS_CTRL_FRAME_DONE_NOTIFICATION,   //!< sent by the board on the master endpoint
+
+    POS_CTRL_LOAD_FRAME_AT,             //!< data is a frame_at_t
 };
 
 enum {
     SEQ_CTRL_PLAY_SLOT,
 
     SEQ_CTRL_UPLOAD_SLOT_START,
-    SEQ_CTRL_UPLOAD_SLOT_FRAME,
+    SEQ_CTRL_UPLOAD_SLOT_DATA,
     SEQ_CTRL_UPLOAD_SLOT_END,
 
-    SEQ_CTRL_DOWNLOAD_SLOT,
-    SEQ_CTRL_DOWNLOAD_SLOT_FRAME,
+    SEQ_CTRL_DOWNLOAD_SLOT,             //!< index is the slot, data is the first frame and the frame number (uint16), reply is the frame number of the slot
+    SEQ_CTRL_DOWNLOAD_SLOT_FRAME,       //!< index is the frame number from the first requested frame
+
+    SEQ_CTRL_STOP,
 };
 
 enum {
@@ -43,7 +43,7 @@ int main(void)
         ret = scb_check_firmware_version(dev, &compat, version, 64);
         printf("Version: %s, compatible: %s\n", version, compat?"OK":"No");
 
-        uint8_t f_speed[] = {1, 2, 3, 4, 5, 0, 0, 7, 8, 9};
+        uint16_t f_speed[] = {60, 120, 180, 240, 300, 0, 0, 420, 480, 540};
         scb_set_out_speed(dev, f_speed, 10);
 
         float f_outs[] = {-1.0, -0.75, -0.5, -0.25, 0, 0.25, 0.5, 0.75, 1.0, 0.8};
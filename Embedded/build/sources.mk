@@ -38,7 +38,10 @@ asf-2.0.0/interrupt/exception.o
 
 OBJS += \
 controller/api_ctrl.o \
-controller/frame_ctrl.o
+controller/frame_ctrl.o \
+controller/gait_ctrl.o \
+controller/pid_ctrl.o \
+controller/seq_ctrl.o
 
 OBJS += \
 io/rx_input.o \
@@ -46,6 +49,7 @@ io/servo_out_bb.o
 
 OBJS += \
 calibration.o \
+conf_store.o \
 core.o \
 exception_handler.o \
 main.o \
@@ -56,7 +60,8 @@ pc_comm_uart.o \
 rc_utils.o \
 sys_conf.o \
 system.o \
-trace.o
+trace.o \
+user_flash.o
 
 OBJS += \
 openscb_advanced.o \
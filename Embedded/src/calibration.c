@@ -42,6 +42,20 @@ void output_calib_init_default(output_calib_data_t *out_calib)
     out_calib->subtrim = DEFAULT_MIDDLE_VALUE;
 }
 
+void output_lut_init_default(const output_calib_data_t *out_calib, output_lut_t *lut)
+{
+    int i;
+
+    lut->enabled = false;
+    lut->reserved = 0;
+    for(i=0; i<OUTPUT_LUT_POINT_NB; i++)
+    {
+        /*point i is for rc value (i - middle point)/4*/
+        int32_t rc_quarter = i - OUTPUT_LUT_POINT_NB/2;
+        lut->point[i] = (_dsp16_t)(out_calib->subtrim + out_calib->angle_180 * rc_quarter / 4);
+    }
+}
+
 void input_calib_init_default(input_calib_data_t *in_calib)
 {
     in_calib->min =  DEFAULT_MIN_VALUE;
@@ -57,8 +71,34 @@ void input_calib_reset_for_calib(input_calib_data_t *in_calib)
 }
 
 
-rc_value_t input_calib_raw_to_rc(const input_calib_data_t *calib, rc_raw_t raw)
+//! helper function: compute 0x8000/range in Q15, 0 if range is invalid
+static int32_t calib_reciprocal(int32_t range)
 {
+    if(range <= 0)
+        return 0;
+
+    return (0x8000 << 15) / range;
+}
+
+void input_calib_update_scale(const input_calib_data_t *calib, input_calib_scale_t *scale)
+{
+    //divisions are only done when calibration changes
+    if(calib->min != scale->data.min ||
+       calib->mid != scale->data.mid ||
+       calib->max != scale->data.max)
+    {
+        scale->data.min = calib->min;
+        scale->data.mid = calib->mid;
+        scale->data.max = calib->max;
+        scale->pos_scale = calib_reciprocal((int32_t)calib->max - calib->mid);
+        scale->neg_scale = calib_reciprocal((int32_t)calib->mid - calib->min);
+    }
+}
+
+rc_value_t input_calib_raw_to_rc(const input_calib_scale_t *scale, rc_raw_t raw)
+{
+    const input_calib_data_t *calib = &scale->data;
+
     if(raw <= calib->min)
         return RC_VALUE_MIN;
 
@@ -69,13 +109,14 @@ rc_value_t input_calib_raw_to_rc(const input_calib_data_t *calib, rc_raw_t raw)
     /*we consider inputs to be divided into two parts:
     - a linear function in negative values
     - another linear function in positive values */
+    /*distance is lower than the range, so the product fits in 32 bits*/
     if(raw >= calib->mid)
     {
-        return (((int32_t)raw - (int32_t)calib->mid) * 0x8000 / ((int32_t)calib->max - calib->mid));
+        return (((int32_t)raw - (int32_t)calib->mid) * scale->pos_scale) >> 15;
     }
     else
     {
-        return (((int32_t)raw - (int32_t)calib->mid) * 0x8000 / ((int32_t)calib->mid - calib->min));
+        return (((int32_t)raw - (int32_t)calib->mid) * scale->neg_scale) >> 15;
     }
 }
 
@@ -94,11 +135,35 @@ rc_raw_t output_calib_rc_to_raw(const output_calib_data_t *calib, rc_value_t rc)
     return raw;
 }
 
+rc_raw_t output_calib_lut_rc_to_raw(const output_calib_data_t *calib,
+        const output_lut_t *lut, rc_value_t rc)
+{
+    /*offset rc to [0 .. 0xFFFF], high bits give the segment, low bits
+    the position inside it*/
+    int32_t pos = (int32_t)rc + 0x8000;
+    int32_t seg = pos >> OUTPUT_LUT_SHIFT;
+    int32_t frac = pos & ((1 << OUTPUT_LUT_SHIFT) - 1);
+    int32_t start = lut->point[seg];
+    int32_t end = lut->point[seg + 1];
+
+    rc_raw_t raw = (rc_raw_t)(start + (((end - start) * frac) >> OUTPUT_LUT_SHIFT));
+
+    /*check valid range*/
+    if(raw <= calib->min)
+        return calib->min;
+    else if(raw >= calib->max)
+        return calib->max;
+
+    return raw;
+}
+
 
 //---------------------------------------------------------
 // CORE INPUT CALIBRATION
 //---------------------------------------------------------
 static bool store_center_values = false;
+static bool stream_inputs = false;
+static input_stream_sample_t stream_sample;
 
 void input_calib_core_run(const system_conf_t *sys_conf)
 {
@@ -107,6 +172,8 @@ void input_calib_core_run(const system_conf_t *sys_conf)
     core_input_t raw;
     const io_class_t *type = core_get_input_type();
 
+    stream_sample.active_bm = 0;
+
     if(type->pre != NULL)
     {
         type->pre();
@@ -117,8 +184,12 @@ void input_calib_core_run(const system_conf_t *sys_conf)
         uint8_t chn = sys_conf->in_conf[i].mapping;
         type->get(chn, &raw);
 
+        stream_sample.raw[i] = raw.value;
+
         if(raw.active)
         {
+            stream_sample.active_bm |= 1 << i;
+
             input_calib_data_t calib;
             memcpy(&calib, &sys_conf->in_conf[i].calib, sizeof(calib));
 
@@ -141,6 +212,15 @@ void input_calib_core_run(const system_conf_t *sys_conf)
         }
     }
     store_center_values = false;
+
+    //push samples every cycle, the core must not wait so a sample is lost
+    //if the endpoint is busy (the host sees it with the cycle counter)
+    if(stream_inputs)
+    {
+        pc_comm_master_send_packet(PCCOM_CORE_CALIBRATION, INPUT_CALIB_STREAM_SAMPLE,
+                0, &stream_sample, sizeof(stream_sample));
+    }
+    stream_sample.cycle++;
 }
 
 //---------------------------------------------------------
@@ -210,11 +290,17 @@ static void set_input_calib_center(pccomm_packet_t *packet)
     store_center_values = true;
 }
 
+static void set_input_calib_stream(pccomm_packet_t *packet)
+{
+    stream_inputs = packet->header.index != 0;
+}
+
 
 static const pc_comm_rx_callback rx_callbacks[] =
 {
     [SET_OUTPUT_CALIB_RAW] = set_output_calib_raw,
     [SET_INPUT_CALIB_CENTER] = set_input_calib_center,
+    [SET_INPUT_CALIB_STREAM] = set_input_calib_stream,
 };
 
 static pccom_callbacks comm_callbacks =
@@ -31,6 +31,17 @@
 #include "sys_conf.h"
 
 
+/**
+ * Input calibration ready to be used: reciprocals of the calibration ranges
+ * are precomputed so the conversion doesn't need any division.
+ */
+typedef struct {
+    input_calib_data_t data;    //!< calibration values the factors are computed from
+    int32_t pos_scale;          //!< 0x8000/(max-mid) in Q15
+    int32_t neg_scale;          //!< 0x8000/(mid-min) in Q15
+} input_calib_scale_t;
+
+
 /**
  * Module initialization
  */
@@ -41,6 +52,12 @@ void core_calib_init(void);
  */
 void output_calib_init_default(output_calib_data_t *out_calib);
 
+/**
+ * Initialize a disabled output calibration table, its points follow
+ * the given linear calibration.
+ */
+void output_lut_init_default(const output_calib_data_t *out_calib, output_lut_t *lut);
+
 /**
  * Initialize input calibration structure with default value
  */
@@ -54,13 +71,22 @@ void input_calib_init_default(input_calib_data_t *in_calib);
 void input_calib_reset_for_calib(input_calib_data_t *in_calib);
 
 /**
- * compute rc_value_t from a raw input using calibration data
+ * Update precomputed input calibration factors, they are only
+ * recomputed if calibration data changed.
  *
  * \param calib calibration structure
+ * \param scale[in,out] precomputed calibration to update
+ */
+void input_calib_update_scale(const input_calib_data_t *calib, input_calib_scale_t *scale);
+
+/**
+ * compute rc_value_t from a raw input using calibration data
+ *
+ * \param scale precomputed calibration, see input_calib_update_scale
  * \param raw value to convert
  * \return value transformed in a more convenient data format
  */
-rc_value_t input_calib_raw_to_rc(const input_calib_data_t *calib, rc_raw_t raw);
+rc_value_t input_calib_raw_to_rc(const input_calib_scale_t *scale, rc_raw_t raw);
 
 /**
  * compute raw output from a rc_value_t data
@@ -71,6 +97,18 @@ rc_value_t input_calib_raw_to_rc(const input_calib_data_t *calib, rc_raw_t raw);
  */
 rc_raw_t output_calib_rc_to_raw(const output_calib_data_t *calib, rc_value_t rc);
 
+/**
+ * compute raw output from a rc_value_t data using a calibration table,
+ * segment lookup is a shift so it takes the same time for all values.
+ *
+ * \param calib calibration structure, only min/max are used
+ * \param lut calibration table
+ * \param rc value to convert
+ * \return value in raw format
+ */
+rc_raw_t output_calib_lut_rc_to_raw(const output_calib_data_t *calib,
+        const output_lut_t *lut, rc_value_t rc);
+
 
 /**
  * Function to be called from main core loop to calibrate inputs
@@ -42,6 +42,26 @@
 
 #define USER_PAGE_ORIG    0x80800000
 
+/*! \name Persistent configuration storage
+ * Reserved at the end of the flash, FLASH region of the linker script
+ * must end before CONF_STORE_ORIG.
+ */
+//! @{
+#define CONF_STORE_ORIG         0x8001E000
+#define CONF_STORE_BANK_SIZE    0x1000
+#define CONF_STORE_BANK_NB      2
+//! @}
+
+/*! \name User flash slots
+ * FLASH_SLOT_NB slots reserved just before the configuration storage.
+ */
+//! @{
+#define USER_FLASH_ORIG         0x80016000
+#define USER_FLASH_SLOT_SIZE    0x1000
+//! last flash page of each slot, keeps the descriptions set after the slot is written
+#define USER_FLASH_DESC_SIZE    0x200
+//! @}
+
 #define APPLI_CPU_SPEED   60000000
 #define APPLI_PBA_SPEED   60000000
 
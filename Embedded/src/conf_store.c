@@ -0,0 +1,348 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+//see header for overview and documentation
+
+#include "conf_store.h"
+
+#include "board.h"
+#include "flashc.h"
+
+#include "openscb_utils.h"
+
+#include <string.h>
+
+
+//! 'SCBC' bank is valid
+#define CONF_BANK_MAGIC         0x53434243
+
+//! id of a free location
+#define CONF_ID_FREE            0xFFFF
+
+//! id of the record closing a save, it has no data
+#define CONF_ID_COMMIT          0xFFFE
+
+//! records are aligned on flash double words
+#define CONF_ALIGN(x)           (((x)+7) & ~7)
+
+#define CONF_BANK_ADDR(no)      (CONF_STORE_ORIG + (no)*CONF_STORE_BANK_SIZE)
+
+
+//! header at the beginning of each bank, written last
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;           //!< the valid bank with highest seq is the active one
+} conf_bank_header_t;
+
+//! header of each record, followed by the data
+typedef struct {
+    uint16_t id;
+    uint16_t size;          //!< size of data following the header
+    uint16_t crc;           //!< crc of id, size, save and data
+    uint16_t save;          //!< number of the save this record belongs to
+} conf_record_t;
+
+
+static int8_t active_bank = -1;
+static uint32_t active_seq;
+static uint32_t free_offset;       //!< first free location in the active bank
+static uint16_t save_nb;           //!< number of the next save
+
+
+//! helper function: compute the crc of a record
+static uint16_t record_crc(uint16_t id, uint16_t size, uint16_t save, const void *data)
+{
+    uint16_t crc = scb_crc16(SCB_CRC16_INIT, &id, sizeof(id));
+    crc = scb_crc16(crc, &size, sizeof(size));
+    crc = scb_crc16(crc, &save, sizeof(save));
+    return scb_crc16(crc, data, size);
+}
+
+//! helper function: check if a record stored in flash is valid
+static bool record_is_valid(const conf_record_t *rec)
+{
+    return rec->crc == record_crc(rec->id, rec->size, rec->save, rec+1);
+}
+
+//! helper function: check if a bank header is valid
+static bool bank_is_valid(int bank)
+{
+    const conf_bank_header_t *hdr = (const void*)CONF_BANK_ADDR(bank);
+    return hdr->magic == CONF_BANK_MAGIC;
+}
+
+//! helper function: check if a flash area is erased
+static bool area_is_erased(uint32_t addr, uint32_t size)
+{
+    const uint32_t *p = (const void*)addr;
+    while(size > 0)
+    {
+        if(*p++ != 0xFFFFFFFF)
+            return false;
+        size -= sizeof(uint32_t);
+    }
+    return true;
+}
+
+/**
+ * Helper function: iterate on records of the active bank.
+ * Start with offset 0, return NULL when there is no more record.
+ */
+static const conf_record_t *next_record(uint32_t *offset)
+{
+    const conf_record_t *rec;
+
+    if(*offset == 0)
+    {
+        *offset = CONF_ALIGN(sizeof(conf_bank_header_t));
+    }
+
+    if(*offset + sizeof(conf_record_t) > CONF_STORE_BANK_SIZE)
+    {
+        return NULL;
+    }
+
+    rec = (const void*)(CONF_BANK_ADDR(active_bank) + *offset);
+    if(rec->id == CONF_ID_FREE ||
+       *offset + sizeof(conf_record_t) + rec->size > CONF_STORE_BANK_SIZE)
+    {
+        return NULL;
+    }
+
+    *offset += CONF_ALIGN(sizeof(conf_record_t) + rec->size);
+    return rec;
+}
+
+//! helper function: find the latest committed record with the given id
+static const conf_record_t *find_record(uint16_t id)
+{
+    const conf_record_t *rec;
+    const conf_record_t *found = NULL;
+    const conf_record_t *pending = NULL;
+    uint32_t offset = 0;
+
+    if(active_bank < 0)
+    {
+        return NULL;
+    }
+
+    while((rec = next_record(&offset)) != NULL)
+    {
+        if(!record_is_valid(rec))
+        {
+            continue;
+        }
+
+        if(rec->id == CONF_ID_COMMIT)
+        {
+            //records left by an interrupted save have an older save number
+            if(pending != NULL && pending->save == rec->save)
+            {
+                found = pending;
+            }
+            pending = NULL;
+        }
+        else if(rec->id == id)
+        {
+            pending = rec;
+        }
+    }
+    return found;
+}
+
+//! helper function: write one record at the given offset of a bank
+static void write_record(int bank, uint32_t offset, const conf_section_t *section)
+{
+    uint32_t addr = CONF_BANK_ADDR(bank) + offset;
+    conf_record_t rec;
+
+    rec.id = section->id;
+    rec.size = section->size;
+    rec.save = save_nb;
+    rec.crc = record_crc(rec.id, rec.size, rec.save, section->data);
+
+    //location is already erased, no need to erase before writing
+    if(section->size > 0)
+    {
+        flashc_memcpy((void*)(addr + sizeof(rec)), section->data, section->size, FALSE);
+    }
+    flashc_memcpy((void*)addr, &rec, sizeof(rec), FALSE);
+}
+
+//! helper function: close the current save with a commit record
+static void write_commit(int bank, uint32_t offset)
+{
+    conf_section_t commit = {CONF_ID_COMMIT, 0, NULL};
+
+    write_record(bank, offset, &commit);
+    save_nb++;
+}
+
+//! helper function: erase a whole bank
+static bool erase_bank(int bank)
+{
+    int page = (CONF_BANK_ADDR(bank) - AVR32_FLASH_ADDRESS) / AVR32_FLASHC_PAGE_SIZE;
+    int i;
+
+    for(i=0; i<CONF_STORE_BANK_SIZE/AVR32_FLASHC_PAGE_SIZE; i++)
+    {
+        if(!flashc_erase_page(page+i, TRUE))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! helper function: write all sections in the inactive bank and activate it
+static bool compact(const conf_section_t *sections, int nb)
+{
+    int bank = (active_bank == 0) ? 1 : 0;
+    uint32_t offset = CONF_ALIGN(sizeof(conf_bank_header_t));
+    conf_bank_header_t hdr;
+    int i;
+
+    if(!erase_bank(bank))
+    {
+        return false;
+    }
+
+    for(i=0; i<nb; i++)
+    {
+        uint32_t rec_size = CONF_ALIGN(sizeof(conf_record_t) + sections[i].size);
+        if(offset + rec_size + sizeof(conf_record_t) > CONF_STORE_BANK_SIZE)
+        {
+            return false;
+        }
+        write_record(bank, offset, &sections[i]);
+        offset += rec_size;
+    }
+    write_commit(bank, offset);
+    offset += sizeof(conf_record_t);
+
+    //bank is valid only once everything has been written
+    hdr.magic = CONF_BANK_MAGIC;
+    hdr.seq = active_seq + 1;
+    flashc_memcpy((void*)CONF_BANK_ADDR(bank), &hdr, sizeof(hdr), FALSE);
+
+    active_bank = bank;
+    active_seq = hdr.seq;
+    free_offset = offset;
+    return true;
+}
+
+
+// see header for documentation
+bool conf_store_load(const conf_section_t *section)
+{
+    const conf_record_t *rec = find_record(section->id);
+
+    if(rec == NULL || rec->size != section->size)
+    {
+        return false;
+    }
+
+    memcpy(section->data, rec+1, section->size);
+    return true;
+}
+
+
+// see header for documentation
+bool conf_store_save(const conf_section_t *sections, int nb)
+{
+    uint32_t offset = free_offset;
+    bool changed = false;
+    int i;
+
+    if(active_bank < 0)
+    {
+        return compact(sections, nb);
+    }
+
+    for(i=0; i<nb; i++)
+    {
+        const conf_record_t *rec = find_record(sections[i].id);
+        uint32_t rec_size = CONF_ALIGN(sizeof(conf_record_t) + sections[i].size);
+
+        //nothing changed, save some flash cycles
+        if(rec != NULL && rec->size == sections[i].size &&
+           memcmp(rec+1, sections[i].data, sections[i].size) == 0)
+        {
+            continue;
+        }
+
+        //no room left for the record and the commit (or garbage after an interrupted write)
+        if(offset + rec_size + sizeof(conf_record_t) > CONF_STORE_BANK_SIZE ||
+           !area_is_erased(CONF_BANK_ADDR(active_bank) + offset, rec_size + sizeof(conf_record_t)))
+        {
+            return compact(sections, nb);
+        }
+
+        write_record(active_bank, offset, &sections[i]);
+        offset += rec_size;
+        free_offset = offset;
+        changed = true;
+    }
+
+    //new records are used only once the commit is written
+    if(changed)
+    {
+        write_commit(active_bank, offset);
+        free_offset = offset + sizeof(conf_record_t);
+    }
+
+    return true;
+}
+
+
+// see header for documentation
+void conf_store_init(void)
+{
+    int i;
+    const conf_record_t *rec;
+
+    active_bank = -1;
+    active_seq = 0;
+    save_nb = 0;
+
+    for(i=0; i<CONF_STORE_BANK_NB; i++)
+    {
+        const conf_bank_header_t *hdr = (const void*)CONF_BANK_ADDR(i);
+        if(bank_is_valid(i) && (active_bank < 0 || hdr->seq > active_seq))
+        {
+            active_bank = i;
+            active_seq = hdr->seq;
+        }
+    }
+
+    //find the first free location of the active bank and the next save number
+    free_offset = CONF_ALIGN(sizeof(conf_bank_header_t));
+    if(active_bank >= 0)
+    {
+        uint32_t offset = 0;
+        while((rec = next_record(&offset)) != NULL)
+        {
+            free_offset = offset;
+            if(record_is_valid(rec))
+            {
+                save_nb = rec->save + 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file conf_store.h
+ * \brief Persistent configuration storage
+ *
+ * Log-structured storage of configuration records in a reserved flash area.
+ * Each record is identified by a 16 bits id, a new version of a record is
+ * appended after the previous ones so flash pages are only erased when the
+ * bank is full. The flash area is split in two banks: when the active one is
+ * full, all current records are compacted in the other one, which becomes
+ * active only once completely written.
+ * Records written by one save share a save number and are followed by a commit
+ * record, they are used only once this commit record is found so an
+ * interrupted save never mixes old and new sections.
+ * All records are protected by a CRC, invalid records are ignored.
+ */
+
+#ifndef CONF_STORE_H_
+#define CONF_STORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+//! one configuration section to load/save
+typedef struct {
+    uint16_t id;        //!< unique identifier of this section (0xFFFE and 0xFFFF are reserved)
+    uint16_t size;      //!< size of data in bytes
+    void *data;         //!< section content
+} conf_section_t;
+
+
+/**
+ * Find the active bank of the configuration store
+ */
+void conf_store_init(void);
+
+/**
+ * Load the latest valid version of a section.
+ *
+ * \param section section to load, data is left untouched if not found
+ * \return false if there is no valid record with this id and size
+ */
+bool conf_store_load(const conf_section_t *section);
+
+/**
+ * Save a set of sections, only sections that changed are written to flash.
+ * Either all or none of the changed sections are saved.
+ * If the active bank is full, all sections are written in the other bank
+ * and sections not listed here are lost.
+ *
+ * \param sections list of sections to save
+ * \param nb number of sections in the list
+ * \return false on flash error
+ */
+bool conf_store_save(const conf_section_t *sections, int nb);
+
+#endif /* CONF_STORE_H_ */
@@ -25,13 +25,13 @@
 #include "api_ctrl.h"
 
 #include "frame_ctrl.h"
+#include "seq_ctrl.h"
 
 #include "rc_utils.h"
 #include "core.h"
 #include "board.h"
 
 #include "FreeRTOS.h"
-#include "semphr.h"
 #include "task.h"
 
 #include "pc_comm.h"
@@ -39,31 +39,50 @@
 //0 means no speed/accel limit
 typedef struct {
     rc_value_t goal;
+    rctime_t stamp;         //!< time the goal has been received
 } sp_out_t;
 
 
-static sp_out_t sp_outs[MAX_OUT_NB];
-static xSemaphoreHandle api_ctrl_mutex;
+/* Goals are double buffered so the core task never waits on the comm task:
+ * the comm task fills the back buffer and then flips the front index, which
+ * is a single word write. This relies on the core task having a higher
+ * priority than the comm task: once it starts reading the front buffer, it
+ * can't be interrupted by a flip. */
+static sp_out_t sp_outs_buf[2][MAX_OUT_NB];
+static volatile uint8_t sp_outs_front;
 static uint32_t controlled_bm;
 
 
 static void set_output_goal(pccomm_packet_t *packet)
 {
-    if(xSemaphoreTake(api_ctrl_mutex, portMAX_DELAY))
+    const pccomm_msg_header_t *header = &packet->header;
+    rctime_t now = system_timer_get_value();
+    uint8_t back = 1 - sp_outs_front;
+    sp_out_t *sp_outs = sp_outs_buf[back];
+    int i;
+
+    //packet might only update part of the goals, start from current ones
+    memcpy(sp_outs, sp_outs_buf[sp_outs_front], sizeof(sp_outs_buf[0]));
+
+    PC_COMM_RX_MEMBERS(packet, sp_outs, goal, MAX_OUT_NB);
+
+    //remember when the goals have been received to measure latency
+    int last = header->index + (header->size - sizeof(pccomm_msg_header_t)) / sizeof(rc_value_t);
+    for(i=header->index; i<last && i<MAX_OUT_NB; i++)
     {
-        PC_COMM_RX_MEMBERS(packet, sp_outs, goal, MAX_OUT_NB);
-        xSemaphoreGive(api_ctrl_mutex);
+        sp_outs[i].stamp = now;
     }
+
+    //publish new goals
+    sp_outs_front = back;
 }
 
 static void req_output_goal(pccomm_packet_t *packet)
 {
     pccomm_msg_header_t *header = &packet->header;
-    if(xSemaphoreTake(api_ctrl_mutex, portMAX_DELAY))
-    {
-        PC_COMM_SEND_MEMBERS(header, sp_outs, goal, MAX_OUT_NB);
-        xSemaphoreGive(api_ctrl_mutex);
-    }
+    sp_out_t *sp_outs = sp_outs_buf[sp_outs_front];
+
+    PC_COMM_SEND_MEMBERS(header, sp_outs, goal, MAX_OUT_NB);
 }
 
 static void set_control_bm(pccomm_packet_t *packet)
@@ -96,36 +115,30 @@ static pccom_callbacks comm_callbacks =
 
 void api_ctrl_init()
 {
-    if(api_ctrl_mutex == NULL)
-    {
-        api_ctrl_mutex = xSemaphoreCreateMutex();
-        if(api_ctrl_mutex == NULL)
-        {
-            FATAL_ERROR();
-        }
-    }
+    sp_outs_front = 0;
 
     frame_ctrl_api_init();
+    seq_ctrl_init();
 
     pc_comm_register_module_callback(PCCOM_API_CTRL, comm_callbacks);
 }
 
 void api_ctrl_update(core_output_t *outputs)
 {
-    if(xSemaphoreTake(api_ctrl_mutex, portMAX_DELAY))
+    int i;
+    const sp_out_t *sp_outs = sp_outs_buf[sp_outs_front];
+
+    for(i=0; i<MAX_OUT_NB; i++)
     {
-        int i;
-        for(i=0; i<MAX_OUT_NB; i++)
+        if(controlled_bm & (1 << i))
         {
-            if(controlled_bm & (1 << i))
-            {
-                outputs[i].value = sp_outs[i].goal;
-                outputs[i].active = true;
-            }
+            outputs[i].value = sp_outs[i].goal;
+            outputs[i].timestamp = sp_outs[i].stamp;
+            outputs[i].active = true;
         }
-        xSemaphoreGive(api_ctrl_mutex);
     }
 
     frame_ctrl_api_update(outputs);
+    seq_ctrl_update(outputs);
 }
 
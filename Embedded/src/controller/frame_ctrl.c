@@ -42,31 +42,240 @@ static void get_current_pos_frame(frame_t *frm)
     }
 }
 
+static void queue_flush(frame_control_t *frm_ctrl)
+{
+    taskENTER_CRITICAL();
+    frm_ctrl->queue_read = frm_ctrl->queue_write;
+    taskEXIT_CRITICAL();
+}
+
+//only called by the frame consumer, the slot can't be overwritten until it is popped
+static const frame_t *queue_peek(const frame_control_t *frm_ctrl)
+{
+    uint8_t read = frm_ctrl->queue_read;
+
+    if(read == frm_ctrl->queue_write)
+    {
+        return NULL;
+    }
+    return &frm_ctrl->queue[read % FRAME_QUEUE_SIZE];
+}
+
+static bool queue_pop(frame_control_t *frm_ctrl, frame_t *frame)
+{
+    bool res = false;
+
+    taskENTER_CRITICAL();
+    if(frm_ctrl->queue_read != frm_ctrl->queue_write)
+    {
+        memcpy(frame, &frm_ctrl->queue[frm_ctrl->queue_read % FRAME_QUEUE_SIZE], sizeof(frame_t));
+        frm_ctrl->queue_read++;
+        res = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return res;
+}
+
+/**
+ * Compute cubic Hermite coefficients of the segment from previous to next frame.
+ *
+ * Tangents follow Catmull-Rom: the tangent at a frame is the slope between the
+ * frames around it. The start tangent is the end tangent of the chained segment,
+ * so speed is continuous across frames. When there is no frame before or after,
+ * the output starts or stops with a null speed.
+ *
+ * \param chained true if the segment follows the previous one without a gap
+ */
+static void compute_segment(frame_control_t *frm_ctrl, bool chained)
+{
+    int i;
+    const frame_t *following = queue_peek(frm_ctrl);
+    int64_t duration = frm_ctrl->duration;
+
+    //only division of the segment, updates multiply the elapsed time by the rate
+    frm_ctrl->rate = (duration != 0) ? ((uint32_t)RC_VALUE_MAX << 16) / duration : 0;
+
+    for(i=0; i<MAX_OUT_NB; i++)
+    {
+        int32_t p1 = frm_ctrl->previous.position[i];
+        int32_t p2 = frm_ctrl->next.position[i];
+        int32_t m1 = 0;
+        int32_t m2 = 0;
+
+        frm_ctrl->start[i] = p1;
+        frm_ctrl->half_delta[i] = p2/2 - p1/2;
+
+        //tangents are in position units per segment duration
+        if(chained && frm_ctrl->slope_duration != 0)
+        {
+            m1 = frm_ctrl->slope[i] * duration / frm_ctrl->slope_duration;
+        }
+
+        frm_ctrl->slope[i] = 0;
+        if(following != NULL && (following->active_bm & (1 << i)))
+        {
+            frm_ctrl->slope[i] = following->position[i] - p1;
+        }
+
+        if(following != NULL && duration + following->duration != 0)
+        {
+            m2 = frm_ctrl->slope[i] * duration / (duration + following->duration);
+        }
+
+        //p(u) = ((a*u + b)*u + c)*u + p1
+        frm_ctrl->coef[i][0] = 2*p1 - 2*p2 + m1 + m2;
+        frm_ctrl->coef[i][1] = -3*p1 + 3*p2 - 2*m1 - m2;
+        frm_ctrl->coef[i][2] = m1;
+    }
+
+    frm_ctrl->slope_duration = (following != NULL) ? frm_ctrl->duration + following->duration : 0;
+}
+
+/**
+ * Evaluate a cubic segment, u is the elapsed fraction of the segment duration
+ */
+static rc_value_t cubic_value(const int32_t *coef, rc_value_t start, dsp16_t u)
+{
+    int64_t res = coef[0];
+
+    res = ((res * u) >> DSP16_QB) + coef[1];
+    res = ((res * u) >> DSP16_QB) + coef[2];
+    res = ((res * u) >> DSP16_QB) + start;
+
+    //Catmull-Rom splines can overshoot frames
+    return (rc_value_t)MAX(MIN(res, RC_VALUE_MAX), RC_VALUE_MIN);
+}
+
+/**
+ * Start a queued frame from the end of the current one. Outputs that were not
+ * part of the current frame start from their current position.
+ */
+static void chain_frame(frame_control_t *frm_ctrl, const frame_t *frame, uint32_t now)
+{
+    int i;
+    bool chained = !frm_ctrl->done;
+
+    //if the current frame was already reached, there is nothing to chain with
+    if(frm_ctrl->done)
+    {
+        frm_ctrl->start_time = now;
+    }
+    else
+    {
+        frm_ctrl->start_time += frm_ctrl->duration;
+        frm_ctrl->done_count++;
+    }
+    frm_ctrl->duration = frame->duration;
+    frm_ctrl->done = false;
+
+    for(i=0; i<MAX_OUT_NB; i++)
+    {
+        if(frm_ctrl->next.active_bm & (1 << i))
+        {
+            frm_ctrl->previous.position[i] = frm_ctrl->next.position[i];
+        }
+        else if(frame->active_bm & (1 << i))
+        {
+            const core_output_t *out = core_get_output(i);
+            if(out != NULL)
+            {
+                frm_ctrl->previous.position[i] = out->value;
+            }
+        }
+    }
+    memcpy(&frm_ctrl->next, frame, sizeof(frame_t));
+
+    compute_segment(frm_ctrl, chained);
+}
+
+/**
+ * Start a loaded frame from the current outputs position
+ */
+static void start_frame(frame_control_t *frm_ctrl, const frame_t *frame, uint32_t start_time)
+{
+    frm_ctrl->start_time = start_time;
+    frm_ctrl->duration = frame->duration;
+    frm_ctrl->done = false;
+
+    get_current_pos_frame(&frm_ctrl->previous);
+    memcpy(&frm_ctrl->next, frame, sizeof(frame_t));
+
+    compute_segment(frm_ctrl, false);
+}
+
 void frame_ctrl_update(frame_control_t *frm_ctrl, core_output_t *outputs)
 {
     int i;
+    frame_t frame;
     uint32_t now = xTaskGetTickCount() * portTICK_RATE_MS;
-    uint32_t delta_t = now - frm_ctrl->start_time;
+    bool waiting, reached;
+    uint32_t delta_t;
+    dsp16_t u;
+    A_ALIGNED dsp16_t half_step[MAX_OUT_NB];
+    A_ALIGNED dsp16_t values[MAX_OUT_NB];
+
+    //the segment is only computed here, the loading task can't see it half written
+    if(frm_ctrl->load_pending)
+    {
+        start_frame(frm_ctrl, &frm_ctrl->load, frm_ctrl->load_time);
+        frm_ctrl->load_pending = false;
+    }
+
+    //frames loaded with a start time hold their start position until then
+    waiting = (int32_t)(now - frm_ctrl->start_time) < 0;
+    delta_t = waiting ? 0 : now - frm_ctrl->start_time;
+
+    //chain queued frames, several short frames might end during one period
+    while(!waiting && delta_t >= frm_ctrl->duration && queue_pop(frm_ctrl, &frame))
+    {
+        chain_frame(frm_ctrl, &frame, now);
+        delta_t = now - frm_ctrl->start_time;
+    }
+
+    //interpolated positions are new data each time they are computed,
+    //the final position keeps the time it has been reached first
+    if(!frm_ctrl->done)
+    {
+        frm_ctrl->stamp = system_timer_get_value();
+    }
+
+    //elapsed fraction of the segment, shared by all outputs
+    reached = !waiting && delta_t >= frm_ctrl->duration;
+    if(reached && !frm_ctrl->done)
+    {
+        frm_ctrl->done = true;
+        frm_ctrl->done_count++;
+    }
+    u = reached ? RC_VALUE_MAX : ((uint64_t)delta_t * frm_ctrl->rate) >> 16;
+
+    if(!reached && frm_ctrl->interpolation == FRAME_INTERP_LINEAR)
+    {
+        //formula: y0 + (y1-y0)/2 * (t/T) + (y1-y0)/2 * (t/T), every partial sum
+        //stays between y0 and y1 so 16 bits vector operations can't overflow
+        dsp16_vect_realmul(half_step, frm_ctrl->half_delta, MAX_OUT_NB, u);
+        dsp16_vect_add(values, frm_ctrl->start, half_step, MAX_OUT_NB);
+        dsp16_vect_add(values, values, half_step, MAX_OUT_NB);
+    }
 
     for(i=0; i<MAX_OUT_NB; i++)
     {
         if(frm_ctrl->next.active_bm & (1 << i))
         {
-            rc_value_t prev_pos = frm_ctrl->previous.position[i];
-            rc_value_t next_pos = frm_ctrl->next.position[i];
-
-            if(delta_t >= frm_ctrl->duration)
+            if(reached)
             {
-                outputs[i].value = next_pos;
-                frm_ctrl->done = true;
+                outputs[i].value = frm_ctrl->next.position[i];
+            }
+            else if(frm_ctrl->interpolation == FRAME_INTERP_CUBIC)
+            {
+                outputs[i].value = cubic_value(frm_ctrl->coef[i], frm_ctrl->start[i], u);
             }
             else
             {
-                //formula: y0 + (y1-y0) * (t/T)
-                outputs[i].value = prev_pos + (2 * dsp16_op_mul( next_pos/2 - prev_pos/2,
-                                       RC_VALUE_MAX * delta_t / frm_ctrl->duration));
+                outputs[i].value = values[i];
             }
 
+            outputs[i].timestamp = frm_ctrl->stamp;
             outputs[i].active = true;
         }
     }
@@ -78,31 +287,81 @@ void frame_ctrl_init(frame_control_t *frm_ctrl)
     frm_ctrl->start_time = 0;
     frm_ctrl->duration = 0;
     frm_ctrl->done = true;
+    frm_ctrl->stamp = 0;
+    frm_ctrl->queue_read = 0;
+    frm_ctrl->queue_write = 0;
+    frm_ctrl->interpolation = FRAME_INTERP_LINEAR;
+    frm_ctrl->slope_duration = 0;
+    frm_ctrl->rate = 0;
+    frm_ctrl->load_pending = false;
     get_current_pos_frame(&frm_ctrl->previous);
     get_current_pos_frame(&frm_ctrl->next);
 }
 
 void frame_ctrl_load_frame(frame_control_t *frm_ctrl, const frame_t *frame)
-{    
-    uint32_t now = xTaskGetTickCount() * portTICK_RATE_MS;
-    
-    frm_ctrl->start_time = now;
-    frm_ctrl->duration = frame->duration;
-    frm_ctrl->done = false;
-    
-    get_current_pos_frame(&frm_ctrl->previous);
-    memcpy(&frm_ctrl->next, frame, sizeof(frame_t));
+{
+    frame_ctrl_load_frame_at(frm_ctrl, frame, xTaskGetTickCount() * portTICK_RATE_MS);
+}
+
+void frame_ctrl_load_frame_at(frame_control_t *frm_ctrl, const frame_t *frame,
+        uint32_t start_time)
+{
+    //the updating task has a higher priority: it can't apply a half written
+    //load, and a load it has not applied yet is simply replaced
+    frm_ctrl->load_pending = false;
+    queue_flush(frm_ctrl);
+
+    memcpy(&frm_ctrl->load, frame, sizeof(frame_t));
+    frm_ctrl->load_time = start_time;
+    frm_ctrl->load_pending = true;
+}
+
+
+void frame_ctrl_set_interpolation(frame_control_t *frm_ctrl, uint8_t interpolation)
+{
+    if(interpolation < FRAME_INTERP_NB)
+    {
+        frm_ctrl->interpolation = interpolation;
+    }
+}
+
+
+bool frame_ctrl_queue_frame(frame_control_t *frm_ctrl, const frame_t *frame)
+{
+    //single writer: only the read counter can change under our feet, and it
+    //only frees slots
+    if(frame_ctrl_queue_free(frm_ctrl) == 0)
+    {
+        return false;
+    }
+
+    memcpy(&frm_ctrl->queue[frm_ctrl->queue_write % FRAME_QUEUE_SIZE], frame, sizeof(frame_t));
+
+    taskENTER_CRITICAL();
+    frm_ctrl->queue_write++;
+    taskEXIT_CRITICAL();
+
+    return true;
+}
+
+
+int frame_ctrl_queue_free(const frame_control_t *frm_ctrl)
+{
+    return FRAME_QUEUE_SIZE - (uint8_t)(frm_ctrl->queue_write - frm_ctrl->queue_read);
 }
 
 
 bool frame_ctrl_done(frame_control_t *frm_ctrl)
 {
-    return frm_ctrl->done;
+    return frm_ctrl->done && !frm_ctrl->load_pending &&
+           frame_ctrl_queue_free(frm_ctrl) == FRAME_QUEUE_SIZE;
 }
 
 
 void frame_ctrl_disable(frame_control_t *frm_ctrl)
 {
+    frm_ctrl->load_pending = false;
+    queue_flush(frm_ctrl);
     frm_ctrl->next.active_bm = 0;
     frm_ctrl->done = true;
 }
@@ -119,20 +378,69 @@ void frame_ctrl_disable(frame_control_t *frm_ctrl)
 
 static frame_control_t api_frm_ctrl;
 
+//! frame done notifications, enabled by the comm task
+static volatile bool frame_notify;
+static uint8_t notified_count;
+
 static void load_frame(pccomm_packet_t *packet)
 {
     frame_ctrl_load_frame(&api_frm_ctrl, (const frame_t *)packet->data);
 }
 
+static void load_frame_at(pccomm_packet_t *packet)
+{
+    const frame_at_t *frame_at = (const frame_at_t *)packet->data;
+    frame_ctrl_load_frame_at(&api_frm_ctrl, &frame_at->frame, frame_at->start_time);
+}
+
 static void disable_frame(pccomm_packet_t *packet)
 {
     frame_ctrl_disable(&api_frm_ctrl);
 }
 
+static void set_interpolation(pccomm_packet_t *packet)
+{
+    frame_ctrl_set_interpolation(&api_frm_ctrl, packet->header.index);
+}
+
+static void set_notification(pccomm_packet_t *packet)
+{
+    //only frames completed from now on are notified
+    notified_count = api_frm_ctrl.done_count;
+    frame_notify = packet->header.index != 0;
+}
+
+static void send_queue_status(const pccomm_msg_header_t *header, bool queued)
+{
+    frame_queue_status_t status;
+
+    status.queued = queued;
+    status.free = frame_ctrl_queue_free(&api_frm_ctrl);
+    pc_comm_send_packet(header->module, header->command, 0, &status, sizeof(status));
+}
+
+static void queue_frame(pccomm_packet_t *packet)
+{
+    bool queued = frame_ctrl_queue_frame(&api_frm_ctrl, (const frame_t *)packet->data);
+    send_queue_status(&packet->header, queued);
+}
+
+static void req_queue_status(pccomm_packet_t *packet)
+{
+    send_queue_status(&packet->header, false);
+}
+
 static const pc_comm_rx_callback rx_callbacks[] =
 {
     [POS_CTRL_LOAD_FRAME] = load_frame,
     [POS_CTRL_DISABLE] = disable_frame,
+    [POS_CTRL_QUEUE_FRAME] = queue_frame,
+    [POS_CTRL_REQ_QUEUE_STATUS] = req_queue_status,
+    [POS_CTRL_SET_INTERPOLATION] = set_interpolation,
+
+    [POS_CTRL_SET_NOTIFICATION] = set_notification,
+
+    [POS_CTRL_LOAD_FRAME_AT] = load_frame_at,
 };
 
 static pccom_callbacks comm_callbacks =
@@ -148,8 +456,34 @@ void frame_ctrl_api_update(core_output_t *outputs)
     frame_ctrl_update(&api_frm_ctrl, outputs);
 }
 
+//! core stage: notify the PC of frames completed since last notification
+static void notify_frame_done(void)
+{
+    frame_done_notification_t notif;
+
+    if(!frame_notify || api_frm_ctrl.done_count == notified_count)
+    {
+        return;
+    }
+
+    notif.done = api_frm_ctrl.done_count - notified_count;
+    notif.free = frame_ctrl_queue_free(&api_frm_ctrl);
+    notif.idle = frame_ctrl_done(&api_frm_ctrl);
+
+    //endpoint busy: completed frames are notified next time
+    if(pc_comm_master_send_packet(PCCOM_POS_CTRL, POS_CTRL_FRAME_DONE_NOTIFICATION, 0,
+            &notif, sizeof(notif)))
+    {
+        notified_count = api_frm_ctrl.done_count;
+    }
+}
+
 void frame_ctrl_api_init(void)
 {
+    //nothing to chain queued frames with until a frame is loaded
+    api_frm_ctrl.done = true;
+
+    core_register_stage(CORE_NOTIFY_PERIOD_MS, notify_frame_done);
     pc_comm_register_module_callback(PCCOM_POS_CTRL, comm_callbacks);
 }
 
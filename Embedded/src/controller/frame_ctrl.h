@@ -30,13 +30,96 @@ typedef struct {
     uint32_t duration;
     uint32_t start_time;
 
+    rctime_t stamp;         //!< time the last output values have been computed
+
     bool done;
+    uint8_t done_count;     //!< free running count of completed frames
+
+    //frames chained after next, written by frame_ctrl_queue_frame, read by frame_ctrl_update
+    frame_t queue[FRAME_QUEUE_SIZE];
+    uint8_t queue_read;     //!< free running read counter
+    uint8_t queue_write;    //!< free running write counter
+
+    uint8_t interpolation;  //!< FRAME_INTERP_LINEAR or FRAME_INTERP_CUBIC
+
+    //frame written by frame_ctrl_load_frame_at, started by frame_ctrl_update
+    frame_t load;
+    uint32_t load_time;
+    volatile bool load_pending;
+
+    //linear segment, computed when a frame is started
+    uint32_t rate;                  //!< elapsed fraction of the segment per ms, Q16
+    A_ALIGNED dsp16_t start[MAX_OUT_NB];        //!< previous positions, copy aligned for dsplib
+    A_ALIGNED dsp16_t half_delta[MAX_OUT_NB];   //!< (next - previous) / 2
+
+    //cubic segment coefficients, computed when a frame is started
+    int32_t coef[MAX_OUT_NB][3];
+    int32_t slope[MAX_OUT_NB];  //!< position delta across the end of the segment
+    uint32_t slope_duration;    //!< duration of slope, 0 if no frame follows
 } frame_control_t;
 
 
+/**
+ * Initialize a frame controller, outputs stay at their current position.
+ */
+void frame_ctrl_init(frame_control_t *frm_ctrl);
+
+/**
+ * Compute interpolated output values, when the current frame is reached the
+ * next queued frame starts right away.
+ */
+void frame_ctrl_update(frame_control_t *frm_ctrl, core_output_t *outputs);
+
+/**
+ * Move to a frame from the current outputs position, the frame queue is flushed.
+ * The frame is started by the next frame_ctrl_update, so this can be called
+ * from a lower priority task than the one updating the frame controller.
+ */
+void frame_ctrl_load_frame(frame_control_t *frm_ctrl, const frame_t *frame);
+
+/**
+ * Same as frame_ctrl_load_frame, but the frame starts at a given time instead
+ * of now. Until then, outputs stay where they are when the frame is loaded.
+ *
+ * \param start_time time in ms, same time base as xTaskGetTickCount
+ */
+void frame_ctrl_load_frame_at(frame_control_t *frm_ctrl, const frame_t *frame,
+        uint32_t start_time);
+
+/**
+ * Select how positions are interpolated between frames.
+ *
+ * \param interpolation FRAME_INTERP_LINEAR or FRAME_INTERP_CUBIC
+ */
+void frame_ctrl_set_interpolation(frame_control_t *frm_ctrl, uint8_t interpolation);
+
+/**
+ * Add a frame to be played after the current one (and the ones already queued).
+ *
+ * \return false if the queue is full
+ */
+bool frame_ctrl_queue_frame(frame_control_t *frm_ctrl, const frame_t *frame);
+
+/**
+ * Get the number of frames that can still be queued.
+ */
+int frame_ctrl_queue_free(const frame_control_t *frm_ctrl);
+
+/**
+ * \return true when the current frame is reached and no frame is queued
+ */
+bool frame_ctrl_done(frame_control_t *frm_ctrl);
+
+/**
+ * Stop moving outputs, the frame queue is flushed.
+ */
+void frame_ctrl_disable(frame_control_t *frm_ctrl);
+
+
 /**
  * Initialize the API frame controller.
- * API frame controller is used to load a frame from API.
+ * API frame controller is used to load a frame from API, frame done
+ * notifications are sent from their own core stage.
  */
 void frame_ctrl_api_init();
 
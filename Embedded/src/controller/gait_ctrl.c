@@ -0,0 +1,327 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Hexapod gait generator. A cycle phase advances with the speed, each leg
+ * follows it with its own offset: the leg swings forward in the air during
+ * the first part of its cycle, then pushes backward on the ground for the
+ * rest of it. Gaits only differ by leg offsets and swing duration.
+ *
+ * Legs are driven in joint space, there is no inverse kinematics: the coxa
+ * sweeps the stroke around its center, femur and tibia are raised during
+ * the swing. The robot turns by giving a longer stroke to one side than to
+ * the other, down to opposite strokes to turn in place.
+ */
+
+#include "gait_ctrl.h"
+
+#include "rc_utils.h"
+#include "core.h"
+#include "board.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "pc_comm.h"
+
+
+//! fraction of a gait cycle, a full cycle is 65536
+#define PHASE(f)    ((uint16_t)((f)*65536))
+
+//! leg offsets and swing duration of a gait
+typedef struct {
+    uint16_t offset[GAIT_LEG_NB];   //!< phase of each leg at cycle start
+    uint16_t swing;                 //!< part of the cycle a leg spends in the air
+} gait_pattern_t;
+
+//! configuration set by the PC, double buffered like pid_ctrl.c
+typedef struct {
+    gait_conf_t conf;
+    gait_leg_t legs[GAIT_LEG_NB];
+} gait_setup_t;
+
+
+//legs are L1 L2 L3 R1 R2 R3, front to rear
+static const gait_pattern_t patterns[GAIT_TYPE_NB] =
+{
+    [GAIT_TRIPOD] = {
+        .offset = {PHASE(0), PHASE(0.5), PHASE(0), PHASE(0.5), PHASE(0), PHASE(0.5)},
+        .swing = PHASE(0.5)
+    },
+    [GAIT_RIPPLE] = {
+        .offset = {PHASE(4./6), PHASE(2./6), PHASE(0), PHASE(1./6), PHASE(5./6), PHASE(3./6)},
+        .swing = PHASE(2./6)
+    },
+    [GAIT_WAVE] = {
+        .offset = {PHASE(2./6), PHASE(1./6), PHASE(0), PHASE(5./6), PHASE(4./6), PHASE(3./6)},
+        .swing = PHASE(1./6)
+    },
+};
+
+static gait_setup_t gait_setup_buf[2];
+static volatile uint8_t gait_setup_front;
+
+//! set by the comm task, a torn update only lasts one period
+static volatile gait_motion_t gait_motion;
+static volatile uint8_t gait_type;
+static volatile bool gait_enabled;
+
+//! cycle phase, a full cycle is 2^32
+static uint32_t gait_phase;
+static uint32_t last_time;
+static rctime_t gait_stamp;
+
+
+//! helper function: absolute value of a dsp16 number that is not the most negative one
+static dsp16_t abs16(dsp16_t x)
+{
+    return (x < 0) ? -x : x;
+}
+
+//! helper function: set one output, unused legs joints are out of range
+static void set_output(core_output_t *outputs, uint8_t out, rc_value_t value)
+{
+    if(out < MAX_OUT_NB)
+    {
+        outputs[out].value = value;
+        outputs[out].timestamp = gait_stamp;
+        outputs[out].active = true;
+    }
+}
+
+
+// see header for documentation
+void gait_ctrl_update(core_output_t *outputs)
+{
+    const gait_setup_t *setup = &gait_setup_buf[gait_setup_front];
+    const gait_pattern_t *pattern = &patterns[gait_type];
+    uint32_t now = xTaskGetTickCount() * portTICK_RATE_MS;
+    uint32_t elapsed = now - last_time;
+    dsp16_t speed = gait_motion.speed;
+    dsp16_t heading = MAX(gait_motion.heading, RC_VALUE_MIN+1);
+    dsp16_t factor[2];
+    dsp16_t rate;
+    uint16_t phase;
+    int i;
+
+    A_ALIGNED rc_value_t femur[GAIT_LEG_NB];
+    A_ALIGNED rc_value_t femur_top[GAIT_LEG_NB];
+    A_ALIGNED rc_value_t femur_ground[GAIT_LEG_NB];
+    A_ALIGNED rc_value_t tibia[GAIT_LEG_NB];
+    A_ALIGNED rc_value_t tibia_top[GAIT_LEG_NB];
+    A_ALIGNED rc_value_t tibia_ground[GAIT_LEG_NB];
+    A_ALIGNED dsp16_t step[GAIT_LEG_NB];
+
+    //always keep track of time, the cycle must not jump when enabled
+    last_time = now;
+    if(!gait_enabled)
+    {
+        return;
+    }
+
+    //stroke of each side, the opposite side can go backward to turn in place
+    factor[0] = MAX(sat_add16(speed, heading), RC_VALUE_MIN+1);
+    factor[1] = MAX(sat_add16(speed, -heading), RC_VALUE_MIN+1);
+
+    //the cycle follows the fastest side, a full cycle lasts period at full speed
+    rate = MAX(abs16(factor[0]), abs16(factor[1]));
+    gait_phase += ((uint64_t)rate * elapsed << 17) / setup->conf.period;
+    phase = gait_phase >> 16;
+
+    //standing outputs are not new data
+    if(rate != 0)
+    {
+        gait_stamp = system_timer_get_value();
+    }
+
+    for(i=0; i<GAIT_LEG_NB; i++)
+    {
+        const gait_leg_t *leg = &setup->legs[i];
+        uint16_t p = phase - pattern->offset[i];
+        rc_value_t stroke = mul16(setup->conf.stride, factor[i / (GAIT_LEG_NB/2)]);
+        rc_value_t x;
+
+        if(rate == 0)
+        {
+            //stand still, all feet on the ground at the middle of their stroke
+            x = 0;
+            step[i] = 0;
+        }
+        else if(p < pattern->swing)
+        {
+            //swing: move forward in the air, from -stroke to stroke
+            step[i] = ((uint32_t)p * RC_VALUE_MAX) / pattern->swing;
+            x = 2*step[i] - RC_VALUE_MAX;
+        }
+        else
+        {
+            //stance: push backward on the ground, from stroke to -stroke
+            x = RC_VALUE_MAX - 2*(((uint32_t)(p - pattern->swing) * RC_VALUE_MAX) /
+                    (65536 - pattern->swing));
+            step[i] = 0;
+        }
+
+        set_output(outputs, leg->coxa, sat_add16(leg->coxa_center, mul16(leg->side * stroke, x)));
+
+        femur_ground[i] = leg->femur_ground;
+        femur_top[i] = sat_add16(leg->femur_ground, leg->side * setup->conf.lift);
+        tibia_ground[i] = leg->tibia_ground;
+        tibia_top[i] = sat_add16(leg->tibia_ground, leg->side * setup->conf.tuck);
+    }
+
+    //raise and lower feet during the swing
+    delta_ramp_vect(femur, femur_top, femur_ground, step, GAIT_LEG_NB);
+    delta_ramp_vect(tibia, tibia_top, tibia_ground, step, GAIT_LEG_NB);
+
+    for(i=0; i<GAIT_LEG_NB; i++)
+    {
+        set_output(outputs, setup->legs[i].femur, femur[i]);
+        set_output(outputs, setup->legs[i].tibia, tibia[i]);
+    }
+}
+
+
+//---------------------------------------------------------
+// COMMUNICATION WITH PC
+//---------------------------------------------------------
+
+static void set_gait_conf(pccomm_packet_t *packet)
+{
+    uint8_t back = 1 - gait_setup_front;
+    gait_setup_t *setup = &gait_setup_buf[back];
+    gait_conf_t *conf = (gait_conf_t*)packet->data;
+
+    if(packet->header.size - sizeof(pccomm_msg_header_t) < sizeof(gait_conf_t) ||
+       conf->period == 0)
+    {
+        return;
+    }
+
+    memcpy(setup, &gait_setup_buf[gait_setup_front], sizeof(gait_setup_t));
+    memcpy(&setup->conf, conf, sizeof(gait_conf_t));
+
+    //publish new configuration
+    gait_setup_front = back;
+}
+
+static void req_gait_conf(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    pc_comm_send_packet(header->module, header->command, 0,
+            &gait_setup_buf[gait_setup_front].conf, sizeof(gait_conf_t));
+}
+
+static void set_gait_legs(pccomm_packet_t *packet)
+{
+    uint8_t back = 1 - gait_setup_front;
+    gait_setup_t *setup = &gait_setup_buf[back];
+
+    //packet might only update some legs, start from current ones
+    memcpy(setup, &gait_setup_buf[gait_setup_front], sizeof(gait_setup_t));
+    pc_comm_receive_array(packet, setup->legs, sizeof(gait_leg_t), GAIT_LEG_NB);
+
+    //publish new configuration
+    gait_setup_front = back;
+}
+
+static void req_gait_legs(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    pc_comm_send_array(header->module, header->command, gait_setup_buf[gait_setup_front].legs,
+            sizeof(gait_leg_t), GAIT_LEG_NB);
+}
+
+static void set_gait_type(pccomm_packet_t *packet)
+{
+    if(packet->header.index < GAIT_TYPE_NB)
+    {
+        gait_type = packet->header.index;
+    }
+}
+
+static void set_gait_motion(pccomm_packet_t *packet)
+{
+    gait_motion_t *motion = (gait_motion_t*)packet->data;
+    gait_motion.speed = motion->speed;
+    gait_motion.heading = motion->heading;
+}
+
+static void set_gait_enabled(pccomm_packet_t *packet)
+{
+    gait_enabled = (packet->header.index != 0);
+}
+
+static const pc_comm_rx_callback rx_callbacks[] =
+{
+    [GAIT_SET_CONF] = set_gait_conf,
+    [GAIT_REQ_CONF] = req_gait_conf,
+
+    [GAIT_SET_LEGS] = set_gait_legs,
+    [GAIT_REQ_LEGS] = req_gait_legs,
+
+    [GAIT_SET_TYPE] = set_gait_type,
+    [GAIT_SET_MOTION] = set_gait_motion,
+    [GAIT_SET_ENABLED] = set_gait_enabled,
+};
+
+static pccom_callbacks comm_callbacks =
+{
+    .callback_nb = SIZEOF_ARRAY(rx_callbacks),
+    .callbacks = rx_callbacks
+};
+
+
+//---------------------------------------------------------
+// MODULE INIT
+//---------------------------------------------------------
+void gait_ctrl_init()
+{
+    gait_setup_t *setup = &gait_setup_buf[0];
+    int i;
+
+    setup->conf.period = 1000;
+    setup->conf.stride = RC_VALUE_MAX / 10;
+    setup->conf.lift = RC_VALUE_MAX / 10;
+    setup->conf.tuck = 0;
+
+    //3 consecutive outputs per leg, right legs are mirrored
+    for(i=0; i<GAIT_LEG_NB; i++)
+    {
+        gait_leg_t *leg = &setup->legs[i];
+
+        leg->coxa = 3*i;
+        leg->femur = 3*i + 1;
+        leg->tibia = 3*i + 2;
+        leg->side = (i < GAIT_LEG_NB/2) ? 1 : -1;
+        leg->coxa_center = 0;
+        leg->femur_ground = 0;
+        leg->tibia_ground = 0;
+    }
+    gait_setup_front = 0;
+
+    gait_motion.speed = 0;
+    gait_motion.heading = 0;
+    gait_type = GAIT_TRIPOD;
+    gait_enabled = false;
+    gait_phase = 0;
+    gait_stamp = 0;
+    last_time = xTaskGetTickCount() * portTICK_RATE_MS;
+
+    pc_comm_register_module_callback(PCCOM_GAIT_CTRL, comm_callbacks);
+}
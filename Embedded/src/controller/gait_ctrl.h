@@ -0,0 +1,43 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GAIT_CTRL_H_
+#define GAIT_CTRL_H_
+
+#include "out_ctrl.h"
+
+/**
+ * Initialize gait controller.
+ * The gait controller makes a hexapod walk without the PC: it moves the
+ * joints of GAIT_LEG_NB legs following a tripod, ripple or wave gait, the
+ * PC only sets the speed and heading. Legs outputs and step shape are set
+ * using the API, the controller is disabled at startup.
+ */
+void gait_ctrl_init(void);
+
+
+/**
+ * Compute outputs value of gait controller, only outputs used by a leg
+ * are modified, and only when the controller is enabled.
+ *
+ * \param outputs list of outputs value to be filled in
+ */
+void gait_ctrl_update(core_output_t *outputs);
+
+#endif /* GAIT_CTRL_H_ */
@@ -0,0 +1,213 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Fixed point PID controller, one loop per output. The loop runs in the
+ * core task each time outputs are computed.
+ */
+
+#include "pid_ctrl.h"
+
+#include "rc_utils.h"
+#include "core.h"
+#include "board.h"
+
+#include "pc_comm.h"
+
+
+//! internal state of one PID loop
+typedef struct {
+    rc_value_t setpoint;
+    rc_value_t integral;        //!< integral term, already multiplied by ki
+    rc_value_t prev_feedback;   //!< feedback value of previous cycle
+    bool running;               //!< false until first cycle after (re)start
+} pid_state_t;
+
+
+/* Configuration is double buffered so the core task never waits on the comm
+ * task, see api_ctrl.c for details. */
+static pid_conf_t pid_conf_buf[2][MAX_OUT_NB];
+static volatile uint8_t pid_conf_front;
+
+static pid_state_t pid_state[MAX_OUT_NB];
+static uint32_t pid_enabled_bm;
+
+
+//! helper function: multiply by 2^shift with saturation
+static rc_value_t sat_shift16(rc_value_t x, uint8_t shift)
+{
+    while(shift > 0)
+    {
+        x = sat_add16(x, x);
+        shift--;
+    }
+    return x;
+}
+
+//! helper function: compute one PID loop
+static rc_value_t pid_compute(const pid_conf_t *conf, pid_state_t *state,
+        rc_value_t feedback)
+{
+    //avoid overflow when negating the most negative value
+    rc_value_t neg_fb = -MAX(feedback, RC_VALUE_MIN+1);
+    rc_value_t error = sat_add16(state->setpoint, neg_fb);
+    rc_value_t p, d, out;
+
+    if(!state->running)
+    {
+        state->integral = 0;
+        state->prev_feedback = feedback;
+        state->running = true;
+    }
+
+    //anti windup: integral term can't go beyond its limit
+    state->integral = integrate(state->integral, error, conf->ki);
+    state->integral = MIN(state->integral, conf->i_limit);
+    state->integral = MAX(state->integral, -conf->i_limit);
+
+    //derivative on measurement, avoid a kick on setpoint change
+    p = dsp16_op_mul(conf->kp, error);
+    d = dsp16_op_mul(conf->kd, sat_add16(state->prev_feedback, neg_fb));
+    state->prev_feedback = feedback;
+
+    out = sat_add16(sat_add16(p, state->integral), d);
+    return sat_shift16(out, conf->gain_shift);
+}
+
+
+// see header for documentation
+void pid_ctrl_update(const core_input_t *inputs, core_output_t *outputs)
+{
+    int i;
+    const pid_conf_t *conf = pid_conf_buf[pid_conf_front];
+
+    for(i=0; i<MAX_OUT_NB; i++)
+    {
+        uint8_t fb = conf[i].feedback;
+
+        if((pid_enabled_bm & (1 << i)) && fb < MAX_IN_NB && inputs[fb].active)
+        {
+            outputs[i].value = pid_compute(&conf[i], &pid_state[i], inputs[fb].value);
+            outputs[i].timestamp = inputs[fb].timestamp;
+            outputs[i].active = true;
+        }
+        else
+        {
+            //restart cleanly next time the loop is used
+            pid_state[i].running = false;
+        }
+    }
+}
+
+
+//---------------------------------------------------------
+// COMMUNICATION WITH PC
+//---------------------------------------------------------
+
+static void set_pid_conf(pccomm_packet_t *packet)
+{
+    uint8_t back = 1 - pid_conf_front;
+    pid_conf_t *conf = pid_conf_buf[back];
+
+    //packet might only update part of the loops, start from current ones
+    memcpy(conf, pid_conf_buf[pid_conf_front], sizeof(pid_conf_buf[0]));
+    pc_comm_receive_array(packet, conf, sizeof(pid_conf_t), MAX_OUT_NB);
+
+    //publish new configuration
+    pid_conf_front = back;
+}
+
+static void req_pid_conf(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    pc_comm_send_array(header->module, header->command, pid_conf_buf[pid_conf_front],
+            sizeof(pid_conf_t), MAX_OUT_NB);
+}
+
+static void set_pid_setpoint(pccomm_packet_t *packet)
+{
+    //each setpoint is written in one access, no need to protect them
+    PC_COMM_RX_MEMBERS(packet, pid_state, setpoint, MAX_OUT_NB);
+}
+
+static void req_pid_setpoint(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    PC_COMM_SEND_MEMBERS(header, pid_state, setpoint, MAX_OUT_NB);
+}
+
+static void set_pid_enabled_bm(pccomm_packet_t *packet)
+{
+    uint32_t *bitmask = (uint32_t*)(packet->data);
+    pid_enabled_bm = *bitmask;
+}
+
+static void req_pid_enabled_bm(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    pc_comm_send_packet(header->module, header->command, 0, &pid_enabled_bm,
+            sizeof(pid_enabled_bm));
+}
+
+static const pc_comm_rx_callback rx_callbacks[] =
+{
+    [PID_SET_CONF] = set_pid_conf,
+    [PID_REQ_CONF] = req_pid_conf,
+
+    [PID_SET_SETPOINT] = set_pid_setpoint,
+    [PID_REQ_SETPOINT] = req_pid_setpoint,
+
+    [PID_SET_ENABLED_BM] = set_pid_enabled_bm,
+    [PID_REQ_ENABLED_BM] = req_pid_enabled_bm,
+};
+
+static pccom_callbacks comm_callbacks =
+{
+    .callback_nb = SIZEOF_ARRAY(rx_callbacks),
+    .callbacks = rx_callbacks
+};
+
+
+//---------------------------------------------------------
+// MODULE INIT
+//---------------------------------------------------------
+void pid_ctrl_init()
+{
+    int i;
+
+    for(i=0; i<MAX_OUT_NB; i++)
+    {
+        pid_conf_t *conf = &pid_conf_buf[0][i];
+
+        //neutral configuration, PC has to set gains before enabling a loop
+        conf->kp = 0;
+        conf->ki = 0;
+        conf->kd = 0;
+        conf->i_limit = RC_VALUE_MAX;
+        conf->gain_shift = 0;
+        conf->feedback = i % MAX_IN_NB;
+
+        pid_state[i].setpoint = 0;
+        pid_state[i].running = false;
+    }
+    pid_conf_front = 0;
+    pid_enabled_bm = 0;
+
+    pc_comm_register_module_callback(PCCOM_PID_CTRL, comm_callbacks);
+}
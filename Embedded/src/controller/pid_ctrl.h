@@ -0,0 +1,43 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PID_CTRL_H_
+#define PID_CTRL_H_
+
+#include "out_ctrl.h"
+
+/**
+ * Initialize PID controller.
+ * The PID controller closes a loop on board for each output: it drives
+ * the output so that one input (the feedback) reaches a setpoint given
+ * by the PC. Gains, setpoints and controlled outputs are set using the API.
+ */
+void pid_ctrl_init(void);
+
+
+/**
+ * Compute outputs value of PID controller, only controlled outputs
+ * with an active feedback input are modified.
+ *
+ * \param inputs list of inputs value (used as feedback)
+ * \param outputs list of outputs value to be filled in
+ */
+void pid_ctrl_update(const core_input_t *inputs, core_output_t *outputs);
+
+#endif /* PID_CTRL_H_ */
@@ -0,0 +1,340 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Sequence controller: a sequence is a list of frames stored in a user flash
+ * slot with the compact encoding of openscb_utils.h. While a sequence is
+ * played, frames are decoded from flash ahead of time to keep the frame
+ * controller queue full, so frames follow each other without any gap.
+ */
+
+#include "seq_ctrl.h"
+
+#include "frame_ctrl.h"
+#include "user_flash.h"
+#include "core.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "pc_comm.h"
+#include "openscb_utils.h"
+
+#include <string.h>
+
+
+//! play requests, slot id otherwise
+#define SEQ_REQ_NONE        -1
+#define SEQ_REQ_STOP        -2
+
+//! the core task applies requests on its next io stage, give it a few periods
+#define SEQ_REQ_TIMEOUT_MS  (4*CORE_PERIOD_MS)
+
+//! sequence being played
+typedef struct {
+    scb_seq_codec_t codec;
+    const uint8_t *data;    //!< next frame to decode
+    const uint8_t *end;     //!< end of sequence data
+    uint16_t remaining;     //!< number of frames still to decode
+    int16_t slot;           //!< -1 if no sequence is played
+} seq_play_t;
+
+static frame_control_t seq_frm_ctrl;
+static seq_play_t play;
+
+//! set by the comm task, applied by the core task
+static volatile int16_t play_request;
+
+//! slot being uploaded, only used by the comm task
+static int16_t upload_slot;
+static uint16_t upload_size;
+
+
+//! helper function: read the number of frames of an encoded sequence
+static uint16_t read_frame_nb(const uint8_t *data)
+{
+    return (data[0] << 8) | data[1];
+}
+
+//! helper function: get number of frames of a sequence slot, 0 if it is not a sequence
+static uint16_t get_frame_nb(uint8_t slot)
+{
+    const slot_header_t *header = user_flash_get_header(slot);
+
+    if(header == NULL || header->type != SLOT_OUT_SEQUENCE ||
+       header->size < SCB_SEQ_HEADER_SIZE)
+    {
+        return 0;
+    }
+    return read_frame_nb(user_flash_get_data(slot));
+}
+
+//! helper function: check that all frames of an encoded sequence can be decoded
+static bool sequence_is_valid(const uint8_t *data, int size)
+{
+    scb_seq_codec_t codec;
+    frame_t frame;
+    uint16_t frame_nb = read_frame_nb(data);
+    int pos = SCB_SEQ_HEADER_SIZE;
+
+    scb_seq_codec_init(&codec);
+    while(frame_nb-- > 0)
+    {
+        int ret = scb_seq_decode_frame(&codec, data + pos, size - pos, &frame);
+        if(ret < 0)
+        {
+            return false;
+        }
+        pos += ret;
+    }
+    return true;
+}
+
+//! helper function: called by the core task to start or stop a sequence
+static void apply_request(int16_t request)
+{
+    frame_ctrl_disable(&seq_frm_ctrl);
+
+    play.slot = -1;
+    play.remaining = 0;
+
+    if(request >= 0)
+    {
+        const uint8_t *data = user_flash_get_data(request);
+
+        play.slot = request;
+        play.remaining = get_frame_nb(request);
+        play.data = data + SCB_SEQ_HEADER_SIZE;
+        play.end = data + user_flash_get_header(request)->size;
+        scb_seq_codec_init(&play.codec);
+    }
+}
+
+//! helper function: wait until the core task has applied the play request, false on timeout
+static bool wait_request_done(void)
+{
+    portTickType start = xTaskGetTickCount();
+
+    while(play_request != SEQ_REQ_NONE)
+    {
+        if((xTaskGetTickCount() - start) * portTICK_RATE_MS > SEQ_REQ_TIMEOUT_MS)
+        {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+    return true;
+}
+
+
+// see header for documentation
+bool seq_ctrl_release_slot(uint8_t slot)
+{
+    //a play request not applied yet might start reading the slot
+    if(!wait_request_done())
+    {
+        return false;
+    }
+
+    if(play.slot == slot)
+    {
+        play_request = SEQ_REQ_STOP;
+        return wait_request_done();
+    }
+    return true;
+}
+
+
+// see header for documentation
+void seq_ctrl_apply_request(void)
+{
+    //the comm task has a lower priority, it can't change the request in between
+    if(play_request != SEQ_REQ_NONE)
+    {
+        apply_request(play_request);
+        play_request = SEQ_REQ_NONE;
+    }
+}
+
+
+void seq_ctrl_update(core_output_t *outputs)
+{
+    //prefetch frames from flash
+    while(play.remaining > 0 && frame_ctrl_queue_free(&seq_frm_ctrl) > 0)
+    {
+        frame_t frame;
+        int ret = scb_seq_decode_frame(&play.codec, play.data, play.end - play.data, &frame);
+        if(ret < 0)
+        {
+            play.remaining = 0;
+            break;
+        }
+
+        frame_ctrl_queue_frame(&seq_frm_ctrl, &frame);
+        play.data += ret;
+        play.remaining--;
+    }
+
+    frame_ctrl_update(&seq_frm_ctrl, outputs);
+}
+
+
+
+
+/*------------------------API----------------------------*/
+
+
+
+
+static void play_slot(pccomm_packet_t *packet)
+{
+    if(get_frame_nb(packet->header.index) > 0)
+    {
+        play_request = packet->header.index;
+    }
+}
+
+static void stop(pccomm_packet_t *packet)
+{
+    play_request = SEQ_REQ_STOP;
+}
+
+static void upload_slot_start(pccomm_packet_t *packet)
+{
+    uint8_t slot = packet->header.index;
+    uint16_t size = *(uint16_t*)packet->data;
+
+    upload_slot = -1;
+    if(slot >= FLASH_SLOT_NB || size < SCB_SEQ_HEADER_SIZE || size > USER_FLASH_DATA_SIZE)
+    {
+        return;
+    }
+
+    //don't erase a sequence while it is read, the upload fails like on an erase error
+    if(seq_ctrl_release_slot(slot) && user_flash_erase(slot))
+    {
+        upload_slot = slot;
+        upload_size = size;
+    }
+}
+
+//! packet index is the block number, blocks are MAX_PAYLOAD_SIZE bytes
+static void upload_slot_data(pccomm_packet_t *packet)
+{
+    uint32_t offset = packet->header.index * MAX_PAYLOAD_SIZE;
+    uint32_t size = packet->header.size - sizeof(pccomm_msg_header_t);
+
+    if(upload_slot >= 0 && offset + size <= upload_size)
+    {
+        user_flash_write_data(upload_slot, offset, packet->data, size);
+    }
+}
+
+static void upload_slot_end(pccomm_packet_t *packet)
+{
+    char desc[SLOT_DESC_SIZE];
+    int len = packet->header.size - sizeof(pccomm_msg_header_t);
+
+    if(upload_slot < 0)
+    {
+        return;
+    }
+
+    len = MAX(MIN(len, SLOT_DESC_SIZE-1), 0);
+    memcpy(desc, packet->data, len);
+    desc[len] = '\0';
+
+    //a missing block or a bad sequence leaves the slot uninitialized
+    if(sequence_is_valid(user_flash_get_data(upload_slot), upload_size))
+    {
+        user_flash_write_header(upload_slot, SLOT_OUT_SEQUENCE, desc, upload_size);
+    }
+    upload_slot = -1;
+}
+
+//! request data is the first frame and the number of frames to send
+static void download_slot(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    uint8_t slot = header->index;
+    uint16_t frame_nb = get_frame_nb(slot);
+    const uint8_t *data = user_flash_get_data(slot);
+    uint16_t first = 0;
+    uint16_t nb = 0xFF;
+    scb_seq_codec_t codec;
+    frame_t frame;
+    int pos = SCB_SEQ_HEADER_SIZE;
+    int i;
+
+    if(header->size >= sizeof(pccomm_msg_header_t) + 2*sizeof(uint16_t))
+    {
+        first = ((uint16_t*)packet->data)[0];
+        nb = ((uint16_t*)packet->data)[1];
+    }
+
+    //packet index is relative to the first frame, so at most 255 frames per request
+    nb = (first < frame_nb) ? MIN(MIN(nb, frame_nb - first), 0xFF) : 0;
+
+    //reply is the real number of frames, the host asks for the next ones
+    pc_comm_send_packet(header->module, header->command, slot, &frame_nb, sizeof(frame_nb));
+
+    scb_seq_codec_init(&codec);
+    for(i=0; i<first+nb; i++)
+    {
+        //slot content has been checked when it was written, frames are sent decoded
+        pos += scb_seq_decode_frame(&codec, data + pos, USER_FLASH_DATA_SIZE - pos, &frame);
+        if(i >= first)
+        {
+            pc_comm_send_packet(header->module, SEQ_CTRL_DOWNLOAD_SLOT_FRAME, i - first,
+                    &frame, sizeof(frame));
+        }
+    }
+}
+
+static const pc_comm_rx_callback rx_callbacks[] =
+{
+    [SEQ_CTRL_PLAY_SLOT] = play_slot,
+
+    [SEQ_CTRL_UPLOAD_SLOT_START] = upload_slot_start,
+    [SEQ_CTRL_UPLOAD_SLOT_DATA] = upload_slot_data,
+    [SEQ_CTRL_UPLOAD_SLOT_END] = upload_slot_end,
+
+    [SEQ_CTRL_DOWNLOAD_SLOT] = download_slot,
+
+    [SEQ_CTRL_STOP] = stop,
+};
+
+static pccom_callbacks comm_callbacks =
+{
+    .callback_nb = SIZEOF_ARRAY(rx_callbacks),
+    .callbacks = rx_callbacks
+};
+
+
+void seq_ctrl_init(void)
+{
+    //nothing to chain frames with until a sequence is played
+    seq_frm_ctrl.done = true;
+
+    play.slot = -1;
+    play.remaining = 0;
+    play_request = SEQ_REQ_NONE;
+    upload_slot = -1;
+
+    pc_comm_register_module_callback(PCCOM_SEQ_CTRL, comm_callbacks);
+}
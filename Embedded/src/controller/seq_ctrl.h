@@ -0,0 +1,50 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SEQ_CTRL_H_
+#define SEQ_CTRL_H_
+
+#include "out_ctrl.h"
+
+/**
+ * Initialize the sequence controller.
+ * Sequences of frames are uploaded in user flash slots, and played from
+ * flash without the PC.
+ */
+void seq_ctrl_init(void);
+
+/**
+ * Stop playing a slot before it is rewritten in flash, called from the comm
+ * task. When this returns true, the slot is not read until it is played again.
+ *
+ * \return false if the core task didn't apply the stop request in time
+ */
+bool seq_ctrl_release_slot(uint8_t slot);
+
+/**
+ * Apply the last play/stop request, called by the core task in all modes.
+ */
+void seq_ctrl_apply_request(void);
+
+/**
+ * Get values from the sequence being played.
+ */
+void seq_ctrl_update(core_output_t *outputs);
+
+#endif /* SEQ_CTRL_H_ */
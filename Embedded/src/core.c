@@ -38,12 +38,21 @@
 #include "io/servo_out_bb.h"
 
 #include "controller/frame_ctrl.h"
+#include "controller/pid_ctrl.h"
+#include "controller/gait_ctrl.h"
+#include "controller/seq_ctrl.h"
 
 #include "calibration.h"
 
 
-//don't need to go faster than inputs/outputs
-#define CORE_PERIOD_MS          14
+//! one periodic stage of the core scheduler
+typedef struct {
+    core_stage_cb cb;           //!< function to execute
+    portTickType period;        //!< execution period in RTOS ticks
+    portTickType deadline;      //!< time of next execution
+    portTickType missed_until;  //!< last deadline already counted as missed
+    core_stage_stats_t stats;
+} core_stage_t;
 
 const io_class_t *input_type = &ppm_input_class;
 const io_class_t *output_type = &servobb_output_class;
@@ -53,6 +62,15 @@ static system_conf_t sys_conf;
 static core_input_t inputs[MAX_IN_NB];
 static core_output_t outputs[MAX_OUT_NB];
 
+static input_calib_scale_t in_calib[MAX_IN_NB];
+
+static core_timing_stats_t timing_stats;
+static volatile bool timing_reset_req;
+static volatile OVERRUN_POLICY overrun_policy = OVERRUN_SKIP;
+
+static core_stage_t stages[CORE_STAGE_MAX_NB];
+static uint8_t stage_nb;
+
 static void core_ios_pre_processing();
 static void core_ios_post_processing();
 
@@ -128,8 +146,8 @@ static void core_inputs_get_all(core_input_t *inputs)
         uint8_t chn = sys_conf.in_conf[i].mapping;
         type->get(chn, &inputs[i]);
 
-        inputs[i].value = input_calib_raw_to_rc(&sys_conf.in_conf[i].calib,
-                inputs[i].value);
+        input_calib_update_scale(&sys_conf.in_conf[i].calib, &in_calib[i]);
+        inputs[i].value = input_calib_raw_to_rc(&in_calib[i], inputs[i].value);
     }
 }
 
@@ -149,9 +167,18 @@ static void core_outputs_set_all(core_output_t *outputs)
         if((chn < sys_conf.output_nb) && enabled)
         {
             core_output_t temp;
-            temp.value = output_calib_rc_to_raw(&sys_conf.out_conf[i].calib,
-                    outputs[chn].value);
+            if(sys_conf.out_lut[i].enabled)
+            {
+                temp.value = output_calib_lut_rc_to_raw(&sys_conf.out_conf[i].calib,
+                        &sys_conf.out_lut[i], outputs[chn].value);
+            }
+            else
+            {
+                temp.value = output_calib_rc_to_raw(&sys_conf.out_conf[i].calib,
+                        outputs[chn].value);
+            }
             temp.active = outputs[chn].active;
+            temp.timestamp = outputs[chn].timestamp;
 
             type->set(i, &temp);
         }
@@ -160,6 +187,7 @@ static void core_outputs_set_all(core_output_t *outputs)
             core_output_t temp;
             temp.value = 0;
             temp.active = false;
+            temp.timestamp = 0;
             type->set(i, &temp);
         }
     }
@@ -191,41 +219,183 @@ void core_change_mode(MODE_T m)
 }
 
 
+//! helper function: restart timing statistics of the task and of all stages
+static void core_reset_timing(void)
+{
+    int i;
+
+    memset(&timing_stats, 0, sizeof(timing_stats));
+    for(i=0; i<stage_nb; i++)
+    {
+        memset(&stages[i].stats, 0, sizeof(core_stage_stats_t));
+        stages[i].stats.period_ms = stages[i].period * portTICK_RATE_MS;
+    }
+}
+
+//! helper function: check if a stage is late, apply overrun policy and set its next deadline
+static void core_check_deadline(core_stage_t *stage, portTickType now)
+{
+    portTickType late = now - stage->deadline;
+    uint32_t late_ms = late * portTICK_RATE_MS;
+
+    stage->stats.max_late_ms = MAX(stage->stats.max_late_ms, late_ms);
+    timing_stats.max_late_ms = MAX(timing_stats.max_late_ms, late_ms);
+
+    if(late >= stage->period)
+    {
+        //catch-up executions are late for the same deadlines, only count new ones
+        portTickType passed = (late / stage->period) * stage->period;
+        portTickType counted = stage->missed_until - stage->deadline;
+        uint32_t missed = late / stage->period;
+
+        if((int32_t)counted > 0 && counted <= late)
+        {
+            missed -= counted / stage->period;
+        }
+        stage->stats.missed_nb += missed;
+        timing_stats.missed_nb += missed;
+        stage->missed_until = stage->deadline + passed;
+
+        //don't try to run all missed cycles, inputs are sampled again
+        //anyway and outputs would be overwritten before being applied
+        if(overrun_policy == OVERRUN_SKIP)
+        {
+            stage->deadline += passed;
+        }
+    }
+
+    //deadlines stay on the same time grid, whatever the delay
+    stage->deadline += stage->period;
+}
+
+//! helper function: run a stage and update its execution time statistics
+static void core_run_stage(core_stage_t *stage)
+{
+    rctime_t start = system_timer_get_value();
+    uint32_t run_us;
+
+    stage->cb();
+
+    run_us = TC4_TICK_TO_US((uint32_t)(rctime_t)(system_timer_get_value() - start));
+    stage->stats.run_nb++;
+    stage->stats.max_run_us = MAX(stage->stats.max_run_us, run_us);
+
+    if(run_us > stage->stats.period_ms * 1000)
+    {
+        stage->stats.overrun_nb++;
+        timing_stats.overrun_nb++;
+    }
+}
+
+// see header for documentation
+bool core_register_stage(uint16_t period_ms, core_stage_cb cb)
+{
+    core_stage_t *stage;
+
+    if(stage_nb >= CORE_STAGE_MAX_NB)
+    {
+        return false;
+    }
+
+    stage = &stages[stage_nb];
+    stage->cb = cb;
+    stage->period = MAX(1, TASK_DELAY_MS(period_ms));
+    memset(&stage->stats, 0, sizeof(core_stage_stats_t));
+    stage->stats.period_ms = stage->period * portTICK_RATE_MS;
+    stage_nb++;
+
+    return true;
+}
+
+//! main stage: read inputs, compute and apply outputs
+static void core_io_stage(void)
+{
+    //make a copy of sys_conf to avoid simultaneous access
+    sys_conf_copy(&sys_conf);
+
+    //the comm task waits for sequence requests whatever the mode is
+    seq_ctrl_apply_request();
+
+    switch(mode)
+    {
+    case OUTPUT_CALIB:
+        //set only one value to help calibrate one servo
+        output_calib_core_run(&sys_conf);
+        break;
+
+    case INPUT_CALIB:
+        //compute min max for all connected inputs
+        input_calib_core_run(&sys_conf);
+        break;
+
+    default:
+    case NORMAL:
+        // inputs
+        core_ios_pre_processing();
+        core_inputs_get_all(inputs);
+        out_ctrl_get_value(&sys_conf, inputs, outputs);
+        core_outputs_set_all(outputs);
+        break;
+    }
+
+    core_ios_post_processing();
+}
+
 void core_main_task(void *arg)
 {
-    const portTickType xDelay = TASK_DELAY_MS(CORE_PERIOD_MS);
-    portTickType xLastWakeTime = xTaskGetTickCount();
+    portTickType last_wake_time = xTaskGetTickCount();
+    int i;
+
+    //all stages run on first cycle
+    for(i=0; i<stage_nb; i++)
+    {
+        stages[i].deadline = last_wake_time;
+        stages[i].missed_until = last_wake_time;
+    }
 
     for(;;)
     {
-        vTaskDelayUntil(&xLastWakeTime, xDelay);
+        rctime_t start = system_timer_get_value();
+        portTickType now = xTaskGetTickCount();
+        portTickType next;
+        uint32_t cycle_us;
 
-        //make a copy of sys_conf to avoid simultaneous access
-        sys_conf_copy(&sys_conf);
+        if(timing_reset_req)
+        {
+            core_reset_timing();
+            timing_reset_req = false;
+        }
+        timing_stats.cycle_nb++;
 
-        switch(mode)
+        //stages due at the same time run in registration order
+        for(i=0; i<stage_nb; i++)
         {
-        case OUTPUT_CALIB:
-            //set only one value to help calibrate one servo
-            output_calib_core_run(&sys_conf);
-            break;
-
-        case INPUT_CALIB:
-            //compute min max for all connected inputs
-            input_calib_core_run(&sys_conf);
-            break;
-
-        default:
-        case NORMAL:
-            // inputs
-            core_ios_pre_processing();
-            core_inputs_get_all(inputs);
-            out_ctrl_get_value(&sys_conf, inputs, outputs);
-            core_outputs_set_all(outputs);
-            break;
+            if((int32_t)(now - stages[i].deadline) >= 0)
+            {
+                core_check_deadline(&stages[i], now);
+                core_run_stage(&stages[i]);
+            }
         }
 
-        core_ios_post_processing();
+        cycle_us = TC4_TICK_TO_US((uint32_t)(rctime_t)(system_timer_get_value() - start));
+        timing_stats.max_cycle_us = MAX(timing_stats.max_cycle_us, cycle_us);
+
+        //sleep until the closest deadline, nothing is due before
+        next = stages[0].deadline;
+        for(i=1; i<stage_nb; i++)
+        {
+            if((int32_t)(stages[i].deadline - next) < 0)
+            {
+                next = stages[i].deadline;
+            }
+        }
+
+        //late stages (catch-up policy) run again without waiting
+        last_wake_time = xTaskGetTickCount();
+        if((int32_t)(next - last_wake_time) > 0)
+        {
+            vTaskDelayUntil(&last_wake_time, next - last_wake_time);
+        }
     }
 }
 
@@ -277,6 +447,82 @@ static void req_output_active(pccomm_packet_t *packet)
     PC_COMM_SEND_MEMBERS(header, core_get_outputs(), active, sys_conf.output_nb);
 }
 
+static void req_output_latency(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    latency_stats_t stats = {0, 0, 0, 0};
+
+    if(output_type->latency != NULL)
+        output_type->latency(&stats, false);
+
+    pc_comm_send_packet(header->module, header->command, 0, &stats, sizeof(stats));
+}
+
+static void reset_output_latency(pccomm_packet_t *packet)
+{
+    latency_stats_t stats;
+
+    if(output_type->latency != NULL)
+        output_type->latency(&stats, true);
+}
+
+static void req_core_timing(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    core_timing_stats_t stats;
+
+    //stats are updated by the core task
+    taskENTER_CRITICAL();
+    memcpy(&stats, &timing_stats, sizeof(stats));
+    taskEXIT_CRITICAL();
+
+    pc_comm_send_packet(header->module, header->command, 0, &stats, sizeof(stats));
+}
+
+static void req_stage_timing(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    core_stage_stats_t stats;
+
+    //a stage that does not exist has a null period
+    memset(&stats, 0, sizeof(stats));
+    if(header->index < stage_nb)
+    {
+        //stats are updated by the core task
+        taskENTER_CRITICAL();
+        memcpy(&stats, &stages[header->index].stats, sizeof(stats));
+        taskEXIT_CRITICAL();
+    }
+
+    pc_comm_send_packet(header->module, header->command, header->index, &stats, sizeof(stats));
+}
+
+static void reset_core_timing(pccomm_packet_t *packet)
+{
+    //done by the core task itself on next cycle
+    timing_reset_req = true;
+}
+
+static void set_overrun_policy(pccomm_packet_t *packet)
+{
+    if(packet->header.index <= OVERRUN_SKIP)
+    {
+        overrun_policy = packet->header.index;
+    }
+}
+
+
+static void set_goal_notification(pccomm_packet_t *packet)
+{
+    rc_value_t tolerance = 0;
+
+    if(packet->header.size >= sizeof(pccomm_msg_header_t) + sizeof(tolerance))
+    {
+        tolerance = *(rc_value_t*)packet->data;
+    }
+    out_ctrl_set_goal_notification(packet->header.index != 0, tolerance);
+}
+
 
 static void req_bootloader(pccomm_packet_t *packet)
 {
@@ -289,6 +535,13 @@ static void req_soft_version(pccomm_packet_t *packet)
     pc_comm_send_string(header->module, header->command, 0, OPENSCB_SOFT_VERSION);
 }
 
+static void req_board_time(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    uint32_t now = xTaskGetTickCount() * portTICK_RATE_MS;
+    pc_comm_send_packet(header->module, header->command, 0, &now, sizeof(now));
+}
+
 
 static const pc_comm_rx_callback core_callbacks[] =
 {
@@ -300,6 +553,16 @@ static const pc_comm_rx_callback core_callbacks[] =
     [REQ_INPUT_ACTIVE] = req_input_active,
     [REQ_OUTPUT_ACTIVE] = req_output_active,
 
+    [REQ_OUTPUT_LATENCY] = req_output_latency,
+    [RESET_OUTPUT_LATENCY] = reset_output_latency,
+
+    [REQ_CORE_TIMING] = req_core_timing,
+    [RESET_CORE_TIMING] = reset_core_timing,
+    [SET_OVERRUN_POLICY] = set_overrun_policy,
+    [REQ_STAGE_TIMING] = req_stage_timing,
+
+    [SET_GOAL_NOTIFICATION] = set_goal_notification,
+
 };
 
 static pccom_callbacks comm_core_callbacks =
@@ -312,6 +575,7 @@ static const pc_comm_rx_callback sys_callbacks[] =
 {
     [RESTART_BOOTLOADER] = req_bootloader,
     [REQ_SOFT_VERSION] = req_soft_version,
+    [REQ_BOARD_TIME] = req_board_time,
 };
 
 static pccom_callbacks comm_sys_callbacks =
@@ -334,6 +598,7 @@ void core_main_init()
     {
         inputs[i].active = false;
         inputs[i].value = 0;
+        inputs[i].timestamp = 0;
     }
 
     output_type->init_module();
@@ -341,14 +606,21 @@ void core_main_init()
     {
         outputs[i].active = false;
         outputs[i].value = 0;
+        outputs[i].timestamp = 0;
         output_type->init_channel(i);
     }
 
     pc_comm_register_module_callback(PCCOM_CORE, comm_core_callbacks);
     pc_comm_register_module_callback(PCCOM_SYSTEM, comm_sys_callbacks);
 
+    //main input/output stage always run first
+    core_register_stage(CORE_PERIOD_MS, core_io_stage);
+    out_ctrl_init();
+
     core_calib_init();
     api_ctrl_init();
+    pid_ctrl_init();
+    gait_ctrl_init();
 
     //Create core task
     xTaskCreate(core_main_task,
@@ -32,6 +32,16 @@
 #include "sys_conf.h"
 
 
+//! main input/output stage period, don't need to go faster than inputs/outputs
+#define CORE_PERIOD_MS          14
+
+//! period of the notifications sent to the PC, every other input/output cycle
+#define CORE_NOTIFY_PERIOD_MS   (2*CORE_PERIOD_MS)
+
+//! stage callback called periodically from the core task
+typedef void (*core_stage_cb)(void);
+
+
 
 /**
  * Get class of input used by core module (use with care)
@@ -61,6 +71,21 @@ const system_conf_t *core_get_sys_conf(void);
 const core_output_t *core_get_output(int i);
 
 
+/**
+ * Register a function to be called periodically by the core task.
+ * Stages due at the same time are executed in registration order, the
+ * main input/output stage being the first one. The core task only wakes
+ * up when a stage is due, and keeps timing statistics for each stage.
+ * This must be called during system initialization, before the core task
+ * starts.
+ *
+ * \param period_ms execution period (RTOS tick resolution)
+ * \param cb function to call
+ * \return false if there is no room left for a new stage
+ */
+bool core_register_stage(uint16_t period_ms, core_stage_cb cb);
+
+
 /**
  * Module initialization
  */
@@ -21,6 +21,7 @@
 
 
 #include "rc_utils.h"
+#include "system.h"
 
 
 /** \name IO type definitions */
@@ -31,6 +32,7 @@ typedef struct _core_input_t
 {
     bool        active;
     rc_value_t  value;
+    rctime_t    timestamp;  ///< system time of the event that produced value
 } __attribute__((packed)) core_input_t;
 
 /** Output type definitions */
@@ -38,6 +40,7 @@ typedef struct _core_output_t
 {
     bool        active;
     rc_value_t  value;
+    rctime_t    timestamp;  ///< system time of the data value is derived from
 } __attribute__((packed)) core_output_t;
 
 /*input class callbacks*/
@@ -49,6 +52,7 @@ typedef void (*io_pre_cb)(void);
 typedef void (*io_get_cb)(uint8_t channel_no, core_input_t *out_val);
 typedef void (*io_set_cb)(uint8_t channel_no, const core_output_t *val);
 typedef bool (*io_post_cb)(void);
+typedef void (*io_latency_cb)(latency_stats_t *stats, bool reset);
 
 /**IO class definition*/
 typedef struct
@@ -64,6 +68,8 @@ typedef struct
     io_get_cb get;
     io_set_cb set;
     io_post_cb post;
+
+    io_latency_cb latency;  ///< data to pulse latency statistics (optional)
 } io_class_t;
 
 
@@ -43,8 +43,6 @@
 
 #define RX_IRQ_LEVEL                    2
 
-#define SYSTEM_TC_CHANNEL               1
-
 #define MAX_PPM_CHANNEL                 16
 
 
@@ -60,6 +58,7 @@ typedef struct
 
     bool active;                            //!< any activity lately on this gpio?
     uint16_t pulse_tick[MAX_PPM_CHANNEL];   //!< last measured pulse width in timer ticks
+    rctime_t pulse_time[MAX_PPM_CHANNEL];   //!< time of the edge that ended the last pulse
 } ppm_input_t;
 
 
@@ -95,13 +94,11 @@ const io_class_t ppm_input_class = {
     .get = ppm_input_get_value,
     .set = NULL,
     .post = NULL,
+    .latency = NULL,
 };
 
 
 
-#define timer_get_value() ((rctime_t)(tc->channel[SYSTEM_TC_CHANNEL].cv & 0xFFFF))
-
-
 void timer_init()
 {
     //free running 16 bits timer, used to measure pulse width
@@ -149,7 +146,7 @@ __attribute__((__interrupt__))
 static void gpio_level_irq()
 {
     //store first interesting value: time
-    irq_fifo[irq_fifo_idx].time = timer_get_value();
+    irq_fifo[irq_fifo_idx].time = system_timer_get_value();
 
     //clear all gpio interrupt flags now.
     //If something happens between now and the end of the interrupt,
@@ -184,6 +181,7 @@ static void process_ppm(ppm_input_t *ppm, uint32_t gpio_level, rctime_t when)
             else
             {
                 ppm->pulse_tick[ppm->index] = pulse;
+                ppm->pulse_time[ppm->index] = when;
                 ppm->index++;
 
                 //defensive check: that should never happen
@@ -256,7 +254,7 @@ void rx_ppm_input_process_input()
     }
 
     //check for lack of activity on all active inputs
-    current_time = timer_get_value();
+    current_time = system_timer_get_value();
 #if 0
     for(i=0; i<rx_input_nb; i++)
     {
@@ -273,6 +271,7 @@ void ppm_input_get_value(uint8_t channel_no, core_input_t *out_val)
     if(channel_no < MAX_PPM_CHANNEL)
     {
         out_val->value = ppm_input.pulse_tick[channel_no];
+        out_val->timestamp = ppm_input.pulse_time[channel_no];
         out_val->active = ppm_input.active;
     }
 }
@@ -43,6 +43,10 @@
 //! send a pulse to each servos every N ms
 #define REFRESH_PERIOD_IN_US        14000
 
+//! oldest data that can be measured: it is applied at most one refresh period after
+//! it is produced, and the system timer wraps around after ~35ms
+#define MAX_LATENCY_TICK            US_TO_TC4_TICK(2*REFRESH_PERIOD_IN_US)
+
 //! protection against strange pulse values
 #define MAX_SERVO_PULSE             US_TO_TC4_TICK(4000)
 #define MIN_SERVO_PULSE             US_TO_TC4_TICK(100)
@@ -80,6 +84,9 @@ AVR32_GPIO_LOCAL.port[0].ovrt = step->gpio_toggle;           \
 typedef struct {
     uint16_t timer_value;           //!< servo pulse width in timer tick
     uint16_t time_left;             //!< time left in the pulse (temp variable for algorithm)
+
+    rctime_t timestamp;             //!< time of the data timer_value is derived from
+    bool timestamp_pending;         //!< timestamp has not been emitted in a pulse yet
 } servo_t;
 
 //! A servo queue is a list of servo that will be handled sequentially
@@ -97,6 +104,9 @@ typedef struct
     uint32_t gpio_toggle;   //!< bitfield of gpio number to be toggled
 
     uint16_t time_to_next_step;         //!< timer value
+
+    bool has_origin;        //!< this step starts a pulse with new data
+    rctime_t origin;        //!< timestamp of the oldest new data started by this step
 } servo_step_t;
 
 
@@ -118,6 +128,13 @@ static servo_step_t *current_step_last;
 static servo_step_t *next_step_first;
 static servo_step_t *next_step_last;
 
+//latency measurement, updated by the IRQ handler
+static uint32_t latency_nb;
+//! sum of timer ticks, 32 bits would overflow after a few minutes
+static uint64_t latency_sum;
+static rctime_t latency_min;
+static rctime_t latency_max;
+
 
 const io_class_t servobb_output_class = {
     .name = "RC servo output",
@@ -131,6 +148,7 @@ const io_class_t servobb_output_class = {
     .get = servobb_get_value,
     .set = servobb_set_value,
     .post = servobb_apply_values,
+    .latency = servobb_get_latency,
 };
 
 
@@ -186,6 +204,47 @@ static void find_next_time_left(servo_queue_t *queue, uint16_t *min_time_left)
 }
 
 
+//! helper function: remember in the step that a servo pulse with new data starts here
+static void tag_step_origin(servo_step_t *step, uint8_t sv_no, rctime_t now)
+{
+    if(servo[sv_no].timestamp_pending)
+    {
+        //keep the oldest data, that's the worst latency
+        rctime_t age = now - servo[sv_no].timestamp;
+
+        //timer has wrapped around since data was produced, age is meaningless
+        if(age > MAX_LATENCY_TICK)
+        {
+            servo[sv_no].timestamp_pending = false;
+            return;
+        }
+
+        if(!step->has_origin || age > (rctime_t)(now - step->origin))
+        {
+            step->origin = servo[sv_no].timestamp;
+        }
+        step->has_origin = true;
+        servo[sv_no].timestamp_pending = false;
+    }
+}
+
+//! helper function: update latency statistics from the IRQ handler
+static inline void record_latency(rctime_t origin)
+{
+    rctime_t latency = system_timer_get_value() - origin;
+
+    if(latency_nb == 0 || latency < latency_min)
+    {
+        latency_min = latency;
+    }
+    if(latency > latency_max)
+    {
+        latency_max = latency;
+    }
+    latency_sum += latency;
+    latency_nb++;
+}
+
 /**
  * \brief TC interrupt handler, execute orders stored in the step structure
  *
@@ -203,6 +262,14 @@ static void servo_hard_tc_irq(void)
 
     TOGGLE_GPIO(current_step);
 
+    //only the first pulse using new data is measured, the same steps
+    //might be executed again if no new values are applied
+    if(current_step->has_origin)
+    {
+        record_latency(current_step->origin);
+        current_step->has_origin = false;
+    }
+
     current_step++;
 
     //this was the last step, switch to next steps set (could be the same or new ones)
@@ -226,6 +293,7 @@ static servo_step_t *generate_servo_step(servo_step_t *new_step)
 {
     int i;
     servo_queue_t queue[MAX_QUEUE_NB];
+    rctime_t now = system_timer_get_value();
 
     //time left to the end of refresh frame
     int32_t refresh_period_needed = US_TO_TC4_TICK( REFRESH_PERIOD_IN_US );
@@ -235,6 +303,7 @@ static servo_step_t *generate_servo_step(servo_step_t *new_step)
 
     //we start all first servo pulses
     GPIO_REG_RESET(new_step->gpio_toggle);
+    new_step->has_origin = false;
     for(i=0; i<MAX_QUEUE_NB; i++)
     {
         if((queue[i].servo_nb > 0))
@@ -243,6 +312,7 @@ static servo_step_t *generate_servo_step(servo_step_t *new_step)
             if(IS_ACTIVE(sv_no))
             {
                 GPIO_REG_SET(new_step->gpio_toggle, IO_BB_PINS[sv_no]);
+                tag_step_origin(new_step, sv_no, now);
             }
         }
     }
@@ -260,6 +330,7 @@ static servo_step_t *generate_servo_step(servo_step_t *new_step)
         //init next step
         new_step++;
         GPIO_REG_RESET(new_step->gpio_toggle);
+        new_step->has_origin = false;
 
         for(i=0; i<MAX_QUEUE_NB; i++)
         {
@@ -288,6 +359,7 @@ static servo_step_t *generate_servo_step(servo_step_t *new_step)
                         if(IS_ACTIVE(sv_no))
                         {
                             GPIO_REG_SET(new_step->gpio_toggle, IO_BB_PINS[sv_no]);
+                            tag_step_origin(new_step, sv_no, now);
                         }
                     }
                 }
@@ -389,6 +461,14 @@ void servobb_set_value(uint8_t channel_no, const core_output_t *out)
     {
         if(out->active)
         {
+            //new data: remember when it was produced to measure latency, an output
+            //reactivated with a frozen timestamp (static goal, reached frame) is not new
+            if(servo[channel_no].timestamp != out->timestamp)
+            {
+                servo[channel_no].timestamp = out->timestamp;
+                servo[channel_no].timestamp_pending = true;
+            }
+
             SET_ACTIVE(channel_no);
             servo[channel_no].timer_value = pulse_tick;
         }
@@ -442,6 +522,35 @@ bool servobb_apply_values()
 
 
 
+// see header for documentation
+void servobb_get_latency(latency_stats_t *stats, bool reset)
+{
+    uint32_t nb;
+    uint64_t sum;
+    rctime_t min, max;
+
+    //copy values atomically, they are updated by the IRQ handler
+    Disable_interrupt_level(SERVOBB_TC_IRQ_LEVEL);
+    nb = latency_nb;
+    sum = latency_sum;
+    min = latency_min;
+    max = latency_max;
+    if(reset)
+    {
+        latency_nb = 0;
+        latency_sum = 0;
+        latency_min = 0;
+        latency_max = 0;
+    }
+    Enable_interrupt_level(SERVOBB_TC_IRQ_LEVEL);
+
+    stats->sample_nb = nb;
+    stats->min_us = TC4_TICK_TO_US(min);
+    stats->max_us = TC4_TICK_TO_US(max);
+    stats->avg_us = (nb > 0) ? TC4_TICK_TO_US(sum / nb) : 0;
+}
+
+
 void servobb_module_init(void)
 {
     int i;
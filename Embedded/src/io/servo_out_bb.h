@@ -85,6 +85,15 @@ void servobb_set_value(uint8_t channel_no, const core_output_t *out);
  */
 bool servobb_apply_values();
 
+/**
+ * Get latency between the time output values were produced and the
+ * first pulse generated with these values.
+ *
+ * \param[out] stats latency statistics in microseconds
+ * \param reset restart statistics from scratch after reading them
+ */
+void servobb_get_latency(latency_stats_t *stats, bool reset);
+
 
 extern const io_class_t servobb_output_class;
 
@@ -37,6 +37,7 @@
 #include "pc_comm.h"
 #include "core.h"
 #include "system.h"
+#include "user_flash.h"
 
 
 static void system_init(void)
@@ -77,6 +78,7 @@ int main()
     trace_init();
     system_init();
     pc_comm_init();
+    user_flash_init();
     core_main_init();
 
     //Start FreeRTOS scheduler
@@ -20,39 +20,374 @@
 
 #include "core.h"
 #include "api_ctrl.h"
+#include "pid_ctrl.h"
+#include "gait_ctrl.h"
+#include "pc_comm.h"
 
-#define SPEED_COEF  8
+//! motion profile fixed point format, values are rc_value_t * 2^PROFILE_SHIFT
+#define PROFILE_SHIFT       8
+//! speed used when acceleration is limited but not speed
+#define PROFILE_MAX_SPEED   (0x10000 << PROFILE_SHIFT)
+//! highest acceleration, also keeps profile computations from overflowing
+#define PROFILE_MAX_ACCEL   (0x100 << PROFILE_SHIFT)
+
+//! limits of one output, converted to profile units per refresh period
+typedef struct {
+    //configuration the increments are computed from
+    uint16_t max_speed;
+    uint16_t max_accel;
+    uint32_t max_jerk;
+
+    int32_t speed;      //!< maximum speed per period, 0 if not limited
+    int32_t accel;      //!< maximum acceleration per period^2, 0 if not limited
+    int32_t jerk;       //!< maximum jerk per period^3, 0 if not limited
+} out_limits_t;
+
+//! state of the acceleration/jerk limited profile of one output
+typedef struct {
+    int32_t pos;        //!< position in profile fixed point format
+    int32_t speed;      //!< speed per refresh period in profile fixed point format
+    int32_t accel;      //!< acceleration per refresh period^2 (jerk limited profile only)
+} out_profile_t;
+
+static out_profile_t profiles[MAX_OUT_NB];
+static out_limits_t out_limits[MAX_OUT_NB];
+
+//! goal reached notifications, set by the comm task
+static volatile bool goal_notify;
+static volatile rc_value_t goal_tolerance;
+//! outputs whose arrival has already been notified
+static uint32_t notified_bm;
+//! goal state of outputs, updated every period and notified at a slower rate
+static uint32_t reached_bm;
+static uint32_t moving_bm;
+
+
+/**
+ * Convert a value in degrees/s^order to profile units per refresh period^order
+ */
+static int32_t to_period_unit(uint32_t value, int order, int32_t max)
+{
+    uint64_t res = value;
+    uint64_t div = 1;
+    int i;
+
+    if(value == 0)
+    {
+        return 0;
+    }
+
+    for(i=0; i<order; i++)
+    {
+        res *= CORE_PERIOD_MS;
+        div *= 1000;
+    }
+
+    /*res * 2^(16+PROFILE_SHIFT) / (360*div): rc_value_t range is 360 degrees,
+    the shift is split in two parts to avoid overflows*/
+    res = MIN(res, UINT64_MAX >> 20);
+    res = (((res << 20) / div) << (16 + PROFILE_SHIFT - 20)) / 360;
+
+    //a limit lower than the resolution must stay a limit
+    return (int32_t)MAX(MIN(res, (uint64_t)max), 1);
+}
+
+/**
+ * Update limits in profile units, divisions are only done when the
+ * configuration changes.
+ */
+static void update_limits(const output_conf_t *conf, out_limits_t *limits)
+{
+    if(conf->max_speed != limits->max_speed ||
+       conf->max_accel != limits->max_accel ||
+       conf->max_jerk != limits->max_jerk)
+    {
+        limits->max_speed = conf->max_speed;
+        limits->max_accel = conf->max_accel;
+        limits->max_jerk = conf->max_jerk;
+
+        limits->speed = to_period_unit(conf->max_speed, 1, PROFILE_MAX_SPEED);
+        limits->accel = to_period_unit(conf->max_accel, 2, PROFILE_MAX_ACCEL);
+        limits->jerk = to_period_unit(conf->max_jerk, 3, PROFILE_MAX_ACCEL);
+    }
+}
+
+//! helper function: restart the profile from the output position if someone else moved it
+static void profile_sync(out_profile_t *profile, rc_value_t cur_pos)
+{
+    if((profile->pos >> PROFILE_SHIFT) != cur_pos)
+    {
+        profile->pos = (int32_t)cur_pos << PROFILE_SHIFT;
+        profile->speed = 0;
+        profile->accel = 0;
+    }
+}
+
+/**
+ * Move toward the goal at constant speed
+ */
+static rc_value_t constant_speed(out_profile_t *profile, rc_value_t cur_pos,
+        rc_value_t goal, int32_t max_speed)
+{
+    int32_t dist;
+
+    profile_sync(profile, cur_pos);
+
+    dist = ((int32_t)goal << PROFILE_SHIFT) - profile->pos;
+    profile->speed = (dist >= 0) ? MIN(dist, max_speed) : MAX(dist, -max_speed);
+    profile->pos += profile->speed;
+
+    return (rc_value_t)(profile->pos >> PROFILE_SHIFT);
+}
+
+
+/**
+ * Trapezoidal profile: accelerate toward the goal until max speed, and start
+ * slowing down when the braking distance reaches the remaining distance.
+ * The goal can change at any time, the profile follows it without speed jumps.
+ */
+static rc_value_t accel_limit(out_profile_t *profile, rc_value_t cur_pos,
+        rc_value_t goal, int32_t max_speed, int32_t accel)
+{
+    int32_t dist, abs_dist, speed;
+    int dir;
+
+    profile_sync(profile, cur_pos);
+
+    dist = ((int32_t)goal << PROFILE_SHIFT) - profile->pos;
+    abs_dist = (dist >= 0) ? dist : -dist;
+    dir = (dist >= 0) ? 1 : -1;
+
+    //close enough and slow enough to stop now, without a step above max speed
+    if(abs_dist <= accel && abs_dist <= max_speed &&
+       profile->speed <= accel && profile->speed >= -accel)
+    {
+        profile->pos = (int32_t)goal << PROFILE_SHIFT;
+        profile->speed = 0;
+        return goal;
+    }
+
+    //speed toward the goal, negative if moving away from it
+    speed = profile->speed * dir;
+
+    /*distance needed to stop after moving at a given speed during this period
+    is speed*(speed+accel)/(2*accel): accelerate if we can still stop after
+    that, slow down if we can't stop anymore at the current speed*/
+    if(speed < 0 ||
+       (int64_t)(speed + accel) * (speed + 2*accel) <= 2 * (int64_t)accel * abs_dist)
+    {
+        speed = MIN(speed + accel, max_speed);
+    }
+    else if((int64_t)speed * (speed + accel) > 2 * (int64_t)accel * abs_dist)
+    {
+        speed -= accel;
+    }
+    else
+    {
+        speed = MIN(speed, max_speed);
+    }
+
+    //never go past the goal
+    speed = MIN(speed, abs_dist);
+
+    profile->speed = speed * dir;
+    profile->pos += profile->speed;
+
+    return (rc_value_t)(profile->pos >> PROFILE_SHIFT);
+}
+
+/**
+ * Distance needed to stop with a jerk limited profile: acceleration goes
+ * from accel to -peak, stays there until speed is low enough, then goes back to 0.
+ * Everything is in profile fixed point format, per refresh period.
+ */
+static int64_t braking_distance(int64_t speed, int64_t accel, int64_t max_accel,
+        int64_t jerk)
+{
+    int64_t peak, ramp, v1, v3, dist;
+
+    //peak deceleration, lower than max_accel for short moves
+    peak = MIN(max_accel, (int64_t)sqrt_u64(accel*accel/2 + speed*jerk));
+    peak = MAX(peak, -accel);
+
+    //ramp from accel to -peak, lasts ramp/jerk periods
+    ramp = accel + peak;
+    dist = (speed*ramp*jerk*6 + accel*ramp*ramp*3 - ramp*ramp*ramp) / (6*jerk*jerk);
+    v1 = speed + (accel*accel - peak*peak) / (2*jerk);
+
+    //constant deceleration until the final ramp back to 0
+    v3 = peak*peak / (2*jerk);
+    if(v1 > v3)
+    {
+        dist += (v1*v1 - v3*v3) / (2*peak);
+    }
+    dist += peak*peak*peak / (6*jerk*jerk);
+
+    return dist;
+}
+
+/**
+ * S-curve profile: same as the trapezoidal one, but acceleration changes by
+ * at most jerk each period. Braking starts when we couldn't stop anymore after
+ * one more period without braking. The last few steps use a trapezoidal
+ * profile with a small acceleration, so the output settles on the goal.
+ */
+static rc_value_t jerk_limit(out_profile_t *profile, rc_value_t cur_pos,
+        rc_value_t goal, int32_t max_speed, int32_t max_accel, int32_t jerk)
+{
+    int32_t dist, abs_dist, speed, accel, target, next_speed, next_accel;
+    int dir;
+
+    profile_sync(profile, cur_pos);
+
+    //a higher jerk means no jerk limit at all
+    jerk = MIN(jerk, max_accel);
+
+    dist = ((int32_t)goal << PROFILE_SHIFT) - profile->pos;
+    abs_dist = (dist >= 0) ? dist : -dist;
+    dir = (dist >= 0) ? 1 : -1;
+
+    //speed and acceleration toward the goal
+    speed = profile->speed * dir;
+    accel = profile->accel * dir;
+
+    //final approach, too close for a jerk limited move
+    if(speed <= jerk && speed >= -jerk &&
+       abs_dist <= braking_distance(jerk, jerk, max_accel, jerk) + jerk)
+    {
+        profile->accel = 0;
+        return accel_limit(profile, cur_pos, goal, max_speed, jerk);
+    }
+
+    //accelerate, stop early enough to reach max speed with a null acceleration
+    target = max_accel;
+    if(speed >= max_speed || (accel > 0 && speed + (int64_t)accel*accel / (2*jerk) >= max_speed))
+    {
+        target = 0;
+    }
+
+    //brake if we couldn't stop anymore after one more period without braking
+    next_accel = (accel < target) ? MIN(accel + jerk, target) : MAX(accel - jerk, target);
+    next_speed = speed + next_accel;
+    if(next_speed > 0 &&
+       braking_distance(next_speed, next_accel, max_accel, jerk) + next_speed >= abs_dist)
+    {
+        target = -max_accel;
+    }
+
+    if(accel < target)
+    {
+        accel = MIN(accel + jerk, target);
+    }
+    else
+    {
+        accel = MAX(accel - jerk, target);
+    }
+
+    //speed is negative when moving away from the goal after it changed
+    speed += accel;
+    speed = MAX(MIN(speed, max_speed), -max_speed);
+    //never go past the goal
+    speed = MIN(speed, abs_dist);
+
+    profile->speed = speed * dir;
+    profile->accel = accel * dir;
+    profile->pos += profile->speed;
+
+    return (rc_value_t)(profile->pos >> PROFILE_SHIFT);
+}
 
 static rc_value_t speed_limit(int out_no, rc_value_t goal)
 {
-    uint8_t speed = core_get_sys_conf()->out_conf[out_no].max_speed;
-    rc_value_t new_pos;
+    out_limits_t *limits = &out_limits[out_no];
+    out_profile_t *profile = &profiles[out_no];
+    int32_t max_speed;
     rc_value_t cur_pos;
 
+    update_limits(&core_get_sys_conf()->out_conf[out_no], limits);
+
     //get output current position
     cur_pos = core_get_output(out_no)->value;
 
+    //0 means no limit
+    max_speed = (limits->speed == 0) ? PROFILE_MAX_SPEED : limits->speed;
 
-    //compute new position,
-    //0 means no speed limit
-    if(speed == 0)
+    //jerk limit is only used with an acceleration limit
+    if(limits->accel != 0 && limits->jerk != 0)
     {
-        new_pos = goal;
+        return jerk_limit(profile, cur_pos, goal, max_speed, limits->accel, limits->jerk);
     }
-    else if(cur_pos < goal)
+    else if(limits->accel != 0)
     {
-        new_pos = MIN(cur_pos + SPEED_COEF*speed, goal);
+        return accel_limit(profile, cur_pos, goal, max_speed, limits->accel);
     }
-    else if(cur_pos > goal)
+    else if(limits->speed != 0)
     {
-        new_pos = MAX(cur_pos - SPEED_COEF*speed, goal);
+        return constant_speed(profile, cur_pos, goal, max_speed);
     }
-    else
+
+    return goal;
+}
+
+
+/**
+ * Find outputs that reached their goal. Goals are the values requested by
+ * controllers, outputs get there once speed limits let them.
+ */
+static void update_goal_reached(const core_output_t *goals, const core_output_t *outputs, int nb)
+{
+    int i;
+
+    reached_bm = 0;
+    moving_bm = 0;
+    for(i=0; i<nb; i++)
     {
-        new_pos = goal;
+        if(goals[i].active)
+        {
+            int32_t dist = (int32_t)outputs[i].value - goals[i].value;
+            if(dist <= goal_tolerance && dist >= -goal_tolerance)
+            {
+                reached_bm |= 1 << i;
+            }
+            else
+            {
+                moving_bm |= 1 << i;
+            }
+        }
     }
 
-    return new_pos;
+    //an output leaving its goal will be notified again
+    notified_bm &= reached_bm;
+}
+
+/**
+ * Notify the PC of outputs that just reached their goal, this is a core stage.
+ * A notification dropped because the endpoint is busy is sent next time.
+ */
+static void notify_goal_reached(void)
+{
+    goal_reached_notification_t notif;
+
+    if(!goal_notify || (reached_bm & ~notified_bm) == 0)
+    {
+        return;
+    }
+
+    notif.reached_bm = reached_bm & ~notified_bm;
+    notif.moving_bm = moving_bm;
+    if(pc_comm_master_send_packet(PCCOM_CORE, GOAL_REACHED_NOTIFICATION, 0,
+            &notif, sizeof(notif)))
+    {
+        notified_bm |= notif.reached_bm;
+    }
+}
+
+
+// see header for documentation
+void out_ctrl_set_goal_notification(bool enable, rc_value_t tolerance)
+{
+    goal_tolerance = (tolerance >= 0) ? tolerance : -tolerance;
+    goal_notify = enable;
 }
 
 
@@ -67,6 +402,8 @@ void out_ctrl_get_value(const system_conf_t *sys_conf, const core_input_t *input
     }
 
     api_ctrl_update(tmp);
+    gait_ctrl_update(tmp);
+    pid_ctrl_update(inputs, tmp);
 
     /* Update core outputs, don't modify value if we don't need to,
      * that way we can remember last servo position to apply
@@ -76,6 +413,7 @@ void out_ctrl_get_value(const system_conf_t *sys_conf, const core_input_t *input
         if(tmp[i].active)
         {
             outputs[i].value = speed_limit(i, tmp[i].value);
+            outputs[i].timestamp = tmp[i].timestamp;
             outputs[i].active = true;
         }
         else
@@ -83,5 +421,14 @@ void out_ctrl_get_value(const system_conf_t *sys_conf, const core_input_t *input
             outputs[i].active = false;
         }
     }
+
+    update_goal_reached(tmp, outputs, sys_conf->output_nb);
+}
+
+
+// see header for documentation
+void out_ctrl_init(void)
+{
+    core_register_stage(CORE_NOTIFY_PERIOD_MS, notify_goal_reached);
 }
 
@@ -24,6 +24,11 @@
 #include "sys_conf.h"
 
 
+/**
+ * Register the goal reached notification stage in the core task
+ */
+void out_ctrl_init(void);
+
 /**
  * Gather output values from the different system modules
  * \param sys_conf system configuration
@@ -32,6 +37,13 @@
  */
 void out_ctrl_get_value(const system_conf_t *sys_conf, const core_input_t *inputs, core_output_t *outputs);
 
+/**
+ * Enable notifications sent to the PC when outputs reach their goal
+ * \param enable true to send notifications
+ * \param tolerance maximum distance between an output and its goal
+ */
+void out_ctrl_set_goal_notification(bool enable, rc_value_t tolerance);
+
 
 
 #endif /* OUT_CTRL_H_ */
@@ -21,6 +21,7 @@
 
 #include "pc_comm_usb.h"
 #include "openscb_utils.h"
+#include "usb_standard_request.h"
 #include "usb_drv.h"
 #include "wdt.h"
 
@@ -36,6 +37,7 @@
 
 
 static xSemaphoreHandle slave_send_mutex;
+static xSemaphoreHandle master_send_mutex;
 static pccom_callbacks registered_callbacks[PCCOM_MODULE_NB];
 
 
@@ -161,6 +163,48 @@ int pc_comm_send_raw_packet(pccomm_packet_t *packet)
 }
 
 
+// see header for documentation
+bool pc_comm_master_send(const void *data, int size, bool wait)
+{
+    const char *buffer = data;
+
+    if(!xSemaphoreTake(master_send_mutex, wait ? portMAX_DELAY : 0))
+    {
+        return false;
+    }
+
+    if(!Is_device_enumerated() || !Is_usb_write_enabled(MASTER_TX_EP))
+    {
+        xSemaphoreGive(master_send_mutex);
+        return false;
+    }
+
+    while(size)
+    {
+        Usb_reset_endpoint_fifo_access(MASTER_TX_EP);
+        size = usb_write_ep_txpacket(MASTER_TX_EP, buffer, size, (const void**)&buffer);
+        Usb_ack_in_ready_send(MASTER_TX_EP);
+    }
+
+    xSemaphoreGive(master_send_mutex);
+    return true;
+}
+
+// see header for documentation
+bool pc_comm_master_send_packet(uint8_t module, uint8_t command, uint8_t index,
+        const void *data, uint8_t data_size)
+{
+    pccomm_packet_t packet;
+
+    if(scb_build_packet(module, command, index, data, data_size, &packet) > 0)
+    {
+        packet.header.module |= PCCOM_MASTER_PACKET_FLAG;
+        return pc_comm_master_send(&packet, packet.header.size, false);
+    }
+    return false;
+}
+
+
 // see header for documentation
 void pc_comm_register_module_callback(uint8_t module, pccom_callbacks callbacks)
 {
@@ -222,7 +266,8 @@ static void comm_task(void *args)
 void pc_comm_init()
 {
     slave_send_mutex = xSemaphoreCreateMutex();
-    if(slave_send_mutex == NULL)
+    master_send_mutex = xSemaphoreCreateMutex();
+    if(slave_send_mutex == NULL || master_send_mutex == NULL)
     {
         FATAL_ERROR();
     }
@@ -97,6 +97,26 @@ int pc_comm_send_packet(uint8_t module, uint8_t command, uint8_t index,
  */
 int pc_comm_send_raw_packet(pccomm_packet_t *packet);
 
+/**
+ * Send raw data to PC on the master endpoint (transfers initiated by the board).
+ *
+ * \param data data to send
+ * \param size size of data
+ * \param wait if false, give up immediately if another task is using the endpoint
+ * \return true if data has been sent, false if the endpoint is busy or not ready
+ */
+bool pc_comm_master_send(const void *data, int size, bool wait);
+
+/**
+ * Send a packet to PC on the master endpoint, module id is marked with
+ * PCCOM_MASTER_PACKET_FLAG. This never blocks, so it can be used by the core,
+ * the packet is dropped if the endpoint is busy.
+ *
+ * \return true if the packet has been sent
+ */
+bool pc_comm_master_send_packet(uint8_t module, uint8_t command, uint8_t index,
+        const void *data, uint8_t data_size);
+
 /**
  *  As you can see, this macro is slightly complicated, but it's actually doing something complicated...
  *
@@ -32,6 +32,19 @@ dsp16_t sat_add16(dsp16_t a, dsp16_t b)
 }
 
 
+//! helper function: interpolate between two points of a sequence
+static rc_value_t sequence_segment(const sequence_point_t *prev,
+        const sequence_point_t *next, dsp16_t dt, rc_value_t amp)
+{
+    if(next->t == prev->t)
+    {
+        return 2*dsp16_op_mul(amp, next->y/2);
+    }
+
+    //original formula is : y0 + (y1-y0)*(t-t0)/(t1-t0)
+    return 2*dsp16_op_mul(amp, ( prev->y/2 + dsp16_op_div(dsp16_op_mul((next->y/2-prev->y/2), dt-prev->t),  next->t-prev->t) ));
+}
+
 //see header
 rc_value_t execute_sequence(const sequence_point_t *pts, dsp16_t dt, rc_value_t amp)
 {
@@ -53,8 +66,108 @@ rc_value_t execute_sequence(const sequence_point_t *pts, dsp16_t dt, rc_value_t
         pts++;
     } while(pts->t!=-1 || pts->y!=-1);
 
-    //original formula is : y0 + (y1-y0)*(t-t0)/(t1-t0)
-    return 2*dsp16_op_mul(amp, ( prev->y/2 + dsp16_op_div(dsp16_op_mul((next->y/2-prev->y/2), dt-prev->t),  next->t-prev->t) ));
+    return sequence_segment(prev, next, dt, amp);
+}
+
+//! helper function: find the points around dt, starting from the cursor
+static void cursor_segment(sequence_cursor_t *cursor, dsp16_t dt,
+        const sequence_point_t **prev, const sequence_point_t **next)
+{
+    static const sequence_point_t empty = {.t=0, .y=0};
+    const sequence_point_t *pts = cursor->pts;
+    uint16_t idx = cursor->next;
+    uint16_t low, high;
+
+    if(cursor->nb == 0)
+    {
+        *prev = *next = &empty;
+        return;
+    }
+
+    //usual case: same segment as last call, or one of the following ones
+    while(idx < cursor->nb && pts[idx].t < dt && idx - cursor->next < 2)
+    {
+        idx++;
+    }
+
+    //idx must be the first point at or after dt
+    if((idx < cursor->nb && pts[idx].t < dt) || (idx > 0 && pts[idx-1].t >= dt))
+    {
+        low = 0;
+        high = cursor->nb;
+        while(low < high)
+        {
+            uint16_t mid = (low + high) / 2;
+            if(pts[mid].t < dt)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        idx = low;
+    }
+    cursor->next = idx;
+
+    //before the first point or after the last one, stay on it
+    *prev = &pts[(idx > 0) ? idx-1 : 0];
+    *next = &pts[(idx < cursor->nb) ? idx : idx-1];
+}
+
+//see header
+void sequence_cursor_init(sequence_cursor_t *cursor, const sequence_point_t *pts)
+{
+    const sequence_point_t *pt = pts;
+
+    while(pt->t!=-1 || pt->y!=-1)
+    {
+        pt++;
+    }
+
+    cursor->pts = pts;
+    cursor->nb = pt - pts;
+    cursor->next = 0;
+}
+
+//see header
+rc_value_t execute_sequence_cursor(sequence_cursor_t *cursor, dsp16_t dt, rc_value_t amp)
+{
+    const sequence_point_t *prev, *next;
+
+    cursor_segment(cursor, dt, &prev, &next);
+    return sequence_segment(prev, next, dt, amp);
+}
+
+//see header
+void execute_sequence_vect(rc_value_t *res, sequence_cursor_t *cursors, dsp16_t *dt,
+        rc_value_t *amp, int size)
+{
+    A_ALIGNED dsp16_t y0[MAX_OUT_NB];
+    A_ALIGNED dsp16_t dy[MAX_OUT_NB];
+    A_ALIGNED dsp16_t elapsed[MAX_OUT_NB];
+    A_ALIGNED dsp16_t length[MAX_OUT_NB];
+    int i;
+
+    //segment search can't be vectorized, gather the segment of each channel
+    for(i=0; i<size; i++)
+    {
+        const sequence_point_t *prev, *next;
+
+        cursor_segment(&cursors[i], dt[i], &prev, &next);
+        y0[i] = prev->y/2;
+        dy[i] = next->y/2 - prev->y/2;
+        elapsed[i] = (next->t == prev->t) ? 0 : dt[i] - prev->t;
+        length[i] = (next->t == prev->t) ? 1 : next->t - prev->t;
+    }
+
+    //same formula as execute_sequence
+    dsp16_vect_dotmul(dy, dy, elapsed, size);
+    dsp16_vect_dotdiv(dy, dy, length, size);
+    dsp16_vect_add(dy, dy, y0, size);
+    dsp16_vect_dotmul(dy, amp, dy, size);
+    dsp16_vect_add(res, dy, dy, size);
 }
 
 //see header
@@ -92,6 +205,35 @@ rc_value_t integrate(rc_value_t current, rc_value_t order, dsp16_t k)
         return (rc_value_t) result;
 }
 
+//see header
+uint32_t sqrt_u64(uint64_t x)
+{
+    uint64_t res = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    //bit by bit computation, from the highest power of 4 lower than x
+    while(bit > x)
+    {
+        bit >>= 2;
+    }
+
+    while(bit != 0)
+    {
+        if(x >= res + bit)
+        {
+            x -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)res;
+}
+
 //see header
 rc_value_t slow_down(rc_value_t current, rc_value_t goal, dsp16_t k)
 {
@@ -122,3 +264,40 @@ rc_value_t delta_ramp(rc_value_t y1, rc_value_t y0, dsp16_t t)
     }
 }
 
+//see header
+void delta_ramp_vect(rc_value_t *res, rc_value_t *y1, rc_value_t *y0, dsp16_t *t, int size)
+{
+    A_ALIGNED dsp16_t base[MAX_OUT_NB];
+    A_ALIGNED dsp16_t delta[MAX_OUT_NB];
+    A_ALIGNED dsp16_t ramp[MAX_OUT_NB];
+    int i;
+
+    //same formulas as delta_ramp: the second half goes back from y1
+    for(i=0; i<size; i++)
+    {
+        bool rising = t[i] < DSP16_Q(0.5f);
+        base[i] = (rising ? y0[i] : y1[i]) / 2;
+        ramp[i] = rising ? t[i] : DSP16_Q(0.5f) - t[i];
+        delta[i] = y1[i]/2 - y0[i]/2;
+    }
+
+    dsp16_vect_dotmul(delta, delta, ramp, size);
+    dsp16_vect_intmul(delta, delta, size, 2);
+    dsp16_vect_add(delta, delta, base, size);
+    dsp16_vect_add(res, delta, delta, size);
+}
+
+//see header
+void slow_down_vect(rc_value_t *current, const rc_value_t *goal, dsp16_t k, int size)
+{
+    int i;
+
+    //dsplib has no clamp operation, keep it branch free for the compiler
+    for(i=0; i<size; i++)
+    {
+        int32_t step = (int32_t)goal[i] - current[i];
+        step = MAX(MIN(step, k), -k);
+        current[i] += step;
+    }
+}
+
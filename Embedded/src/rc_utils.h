@@ -88,6 +88,15 @@ typedef struct {
 
 #define END_OF_SEQ          {.t=-1, .y=-1}
 
+/**
+ * Position in a sequence, to evaluate it without scanning it from the start
+ */
+typedef struct {
+    const sequence_point_t *pts;
+    uint16_t nb;        //!< number of points, END_OF_SEQ excluded
+    uint16_t next;      //!< index of the first point at or after the last time
+} sequence_cursor_t;
+
 
 
 
@@ -103,6 +112,77 @@ typedef struct {
  */
 rc_value_t execute_sequence(const sequence_point_t *pts, dsp16_t dt, rc_value_t amp);
 
+/**
+ * Attach a cursor to a sequence, points are counted once here.
+ *
+ * \param pts list of diagram points, ending with END_OF_SEQ
+ */
+void sequence_cursor_init(sequence_cursor_t *cursor, const sequence_point_t *pts);
+
+/**
+ * Same as execute_sequence, but the search starts from the segment used by
+ * the previous call: this is O(1) when time moves forward by small steps,
+ * and a binary search otherwise (time going back, large jumps).
+ * Before the first point and after the last one, their value is used.
+ *
+ * \param cursor cursor attached to the sequence
+ * \param dt current timing in the diagram fixed point: [0..1]
+ * \param amp amplitude to apply to the diagram
+ */
+rc_value_t execute_sequence_cursor(sequence_cursor_t *cursor, dsp16_t dt, rc_value_t amp);
+
+/**
+ * \name Batch versions
+ *
+ * Evaluate several channels in one call with dsplib vector operations.
+ * Arrays hold at most MAX_OUT_NB values and must be word aligned (A_ALIGNED).
+ */
+/// @{
+
+/**
+ * execute_sequence_cursor on several channels, each one has its own cursor
+ * (they can be attached to the same sequence), time and amplitude.
+ *
+ * \param res[out] value of each channel
+ */
+void execute_sequence_vect(rc_value_t *res, sequence_cursor_t *cursors, dsp16_t *dt,
+        rc_value_t *amp, int size);
+
+/**
+ * Go from y0 to y1 and back to y0 while t goes from 0 to 1, for each channel.
+ *
+ * \param res[out] value of each channel
+ */
+void delta_ramp_vect(rc_value_t *res, rc_value_t *y1, rc_value_t *y0, dsp16_t *t, int size);
+
+/**
+ * Move each current value toward its goal, by at most k.
+ *
+ * \param current[in,out] values to move
+ */
+void slow_down_vect(rc_value_t *current, const rc_value_t *goal, dsp16_t k, int size);
+
+/// @}
+
+/**
+ * Add two fixed point numbers, saturate the result instead of wrapping around
+ */
+dsp16_t sat_add16(dsp16_t a, dsp16_t b);
+
+/**
+ * Integrate an order: return current + order*k, saturated to rc_value_t range
+ *
+ * \param current current integrated value
+ * \param order value to integrate
+ * \param k integration coefficient
+ */
+rc_value_t integrate(rc_value_t current, rc_value_t order, dsp16_t k);
+
+/**
+ * Integer square root, rounded down
+ */
+uint32_t sqrt_u64(uint64_t x);
+
 
 
 /// @}
@@ -19,23 +19,198 @@
 #include "sys_conf.h"
 
 #include "calibration.h"
+#include "conf_store.h"
 #include "pc_comm.h"
 #include "core.h"
 
 #include "FreeRTOS.h"
 #include "semphr.h"
 
+#include "openscb_utils.h"
+
 #include "io/rx_input.h"
 #include "io/servo_out_bb.h"
 
 
-#define DEFAULT_CONF_SLOT               0
-#define CURRENT_COMPATIBILITY_MAGIC     0xCAFE0001
+#define CURRENT_COMPATIBILITY_MAGIC     0xCAFE0003
+
+//! configuration store record ids
+#define CONF_ID_GLOBAL                  0x0000
+#define CONF_ID_INPUT(i)                (0x0100 + (i))
+#define CONF_ID_OUTPUT(i)               (0x0200 + (i))
+#define CONF_ID_OUTPUT_LUT(i)           (0x0300 + (i))
+
+#define CONF_SECTION_NB                 (1 + MAX_IN_NB + 2*MAX_SERVO_NB)
+
+//! part of the configuration not related to one input/output
+typedef struct {
+    uint32_t compatibility_magic;
+    uint32_t servo_active_bm;
+    uint8_t input_nb;
+    uint8_t output_nb;
+} sys_conf_global_t;
 
 
 static system_conf_t sys_conf;
 static xSemaphoreHandle sysconf_mutex;
 
+//! temporary copy used to load/save the configuration (too big for the stack)
+static system_conf_t conf_buffer;
+static sys_conf_global_t conf_global;
+static conf_section_t conf_sections[CONF_SECTION_NB];
+
+//! configuration image exchanged with the PC, rounded up to whole blocks
+static union {
+    sys_conf_image_t image;
+    uint8_t blocks[SYS_CONF_IMAGE_BLOCK_NB][SYS_CONF_IMAGE_BLOCK_SIZE];
+} conf_image;
+static uint32_t conf_image_rcv_bm;     //!< blocks received during a SET transfer
+
+
+//! helper function: describe all sections of a configuration for conf_store
+static void build_conf_sections(system_conf_t *conf, sys_conf_global_t *global)
+{
+    int i;
+    conf_section_t *section = conf_sections;
+
+    section->id = CONF_ID_GLOBAL;
+    section->size = sizeof(sys_conf_global_t);
+    section->data = global;
+    section++;
+
+    for(i=0; i<MAX_IN_NB; i++)
+    {
+        section->id = CONF_ID_INPUT(i);
+        section->size = sizeof(input_conf_t);
+        section->data = &conf->in_conf[i];
+        section++;
+    }
+
+    for(i=0; i<MAX_SERVO_NB; i++)
+    {
+        section->id = CONF_ID_OUTPUT(i);
+        section->size = sizeof(output_conf_t);
+        section->data = &conf->out_conf[i];
+        section++;
+    }
+
+    for(i=0; i<MAX_SERVO_NB; i++)
+    {
+        section->id = CONF_ID_OUTPUT_LUT(i);
+        section->size = sizeof(output_lut_t);
+        section->data = &conf->out_lut[i];
+        section++;
+    }
+}
+
+static void save_sys_conf(pccomm_packet_t *packet)
+{
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        memcpy(&conf_buffer, &sys_conf, sizeof(system_conf_t));
+        xSemaphoreGive(sysconf_mutex);
+    }
+
+    conf_global.compatibility_magic = conf_buffer.compatibility_magic;
+    conf_global.servo_active_bm = conf_buffer.servo_active_bm;
+    conf_global.input_nb = conf_buffer.input_nb;
+    conf_global.output_nb = conf_buffer.output_nb;
+
+    build_conf_sections(&conf_buffer, &conf_global);
+    if(!conf_store_save(conf_sections, CONF_SECTION_NB))
+    {
+        TRACE("Cannot save system configuration\n");
+    }
+}
+
+static void req_load_sys_conf(pccomm_packet_t *packet)
+{
+    load_sys_conf();
+}
+
+static void req_sys_conf_image(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    sys_conf_image_t *image = &conf_image.image;
+
+    //an incomplete SET transfer is lost
+    conf_image_rcv_bm = 0;
+
+    memset(&conf_image, 0, sizeof(conf_image));
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        image->version = SYS_CONF_IMAGE_VERSION;
+        image->input_nb = sys_conf.input_nb;
+        image->output_nb = sys_conf.output_nb;
+        image->servo_active_bm = sys_conf.servo_active_bm;
+        memcpy(image->in_conf, sys_conf.in_conf, sizeof(image->in_conf));
+        memcpy(image->out_conf, sys_conf.out_conf, sizeof(image->out_conf));
+        memcpy(image->out_lut, sys_conf.out_lut, sizeof(image->out_lut));
+        xSemaphoreGive(sysconf_mutex);
+    }
+
+    pc_comm_send_array(header->module, header->command, conf_image.blocks,
+            SYS_CONF_IMAGE_BLOCK_SIZE, SYS_CONF_IMAGE_BLOCK_NB);
+}
+
+static void set_sys_conf_image(pccomm_packet_t *packet)
+{
+    const sys_conf_image_t *image = &conf_image.image;
+    const uint32_t all_blocks = (1 << SYS_CONF_IMAGE_BLOCK_NB) - 1;
+    uint8_t block = packet->header.index;
+
+    if(block >= SYS_CONF_IMAGE_BLOCK_NB)
+    {
+        return;
+    }
+
+    //first block starts a new transfer
+    if(block == 0)
+    {
+        conf_image_rcv_bm = 0;
+    }
+    pc_comm_receive_array(packet, conf_image.blocks, SYS_CONF_IMAGE_BLOCK_SIZE,
+            SYS_CONF_IMAGE_BLOCK_NB);
+    conf_image_rcv_bm |= 1 << block;
+
+    //apply the whole configuration at once when everything is received
+    if(conf_image_rcv_bm == all_blocks)
+    {
+        conf_image_rcv_bm = 0;
+        if(image->version != SYS_CONF_IMAGE_VERSION)
+        {
+            TRACE("Wrong configuration version: %d\n", image->version);
+            return;
+        }
+
+        if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+        {
+            sys_conf.input_nb = MIN(image->input_nb, MAX_IN_NB);
+            sys_conf.output_nb = MIN(image->output_nb, MAX_SERVO_NB);
+            sys_conf.servo_active_bm = image->servo_active_bm;
+            memcpy(sys_conf.in_conf, image->in_conf, sizeof(image->in_conf));
+            memcpy(sys_conf.out_conf, image->out_conf, sizeof(image->out_conf));
+            memcpy(sys_conf.out_lut, image->out_lut, sizeof(image->out_lut));
+            xSemaphoreGive(sysconf_mutex);
+        }
+    }
+}
+
+static void req_sys_conf_digest(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    sys_conf_digest_t digest;
+
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        scb_compute_sys_conf_digest(sys_conf.in_conf, sys_conf.out_conf,
+                sys_conf.out_lut, sys_conf.servo_active_bm, &digest);
+        xSemaphoreGive(sysconf_mutex);
+    }
+
+    pc_comm_send_packet(header->module, header->command, 0, &digest, sizeof(digest));
+}
+
 
 static void set_input_map(pccomm_packet_t *packet)
 {
@@ -114,6 +289,44 @@ static void req_output_speed(pccomm_packet_t *packet)
     }
 }
 
+static void set_output_accel(pccomm_packet_t *packet)
+{
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        PC_COMM_RX_MEMBERS(packet, sys_conf.out_conf, max_accel, sys_conf.output_nb);
+        xSemaphoreGive(sysconf_mutex);
+    }
+}
+
+static void req_output_accel(pccomm_packet_t *packet)
+{
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        pccomm_msg_header_t *header = &packet->header;
+        PC_COMM_SEND_MEMBERS(header, sys_conf.out_conf, max_accel, sys_conf.output_nb);
+        xSemaphoreGive(sysconf_mutex);
+    }
+}
+
+static void set_output_jerk(pccomm_packet_t *packet)
+{
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        PC_COMM_RX_MEMBERS(packet, sys_conf.out_conf, max_jerk, sys_conf.output_nb);
+        xSemaphoreGive(sysconf_mutex);
+    }
+}
+
+static void req_output_jerk(pccomm_packet_t *packet)
+{
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        pccomm_msg_header_t *header = &packet->header;
+        PC_COMM_SEND_MEMBERS(header, sys_conf.out_conf, max_jerk, sys_conf.output_nb);
+        xSemaphoreGive(sysconf_mutex);
+    }
+}
+
 
 static void req_input_calib_value(pccomm_packet_t *packet)
 {
@@ -153,6 +366,27 @@ static void set_output_calib_value(pccomm_packet_t *packet)
     }
 }
 
+static void req_output_lut(pccomm_packet_t *packet)
+{
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        pccomm_msg_header_t *header = &packet->header;
+        pc_comm_send_array(header->module, header->command, sys_conf.out_lut,
+                sizeof(output_lut_t), sys_conf.output_nb);
+        xSemaphoreGive(sysconf_mutex);
+    }
+}
+
+static void set_output_lut(pccomm_packet_t *packet)
+{
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        pc_comm_receive_array(packet, sys_conf.out_lut, sizeof(output_lut_t),
+                sys_conf.output_nb);
+        xSemaphoreGive(sysconf_mutex);
+    }
+}
+
 static void req_output_active_bm(pccomm_packet_t *packet)
 {
     if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
@@ -178,10 +412,8 @@ static void set_output_active_bm(pccomm_packet_t *packet)
 
 static const pc_comm_rx_callback sys_conf_callbacks[] =
 {
-	/*
     [SAVE_SYS_CONF] = save_sys_conf,
     [LOAD_SYS_CONF] = req_load_sys_conf,
-    */
 
     [SET_INPUT_MAPPING] = set_input_map,
     [REQ_INPUT_MAPPING] = req_input_map,
@@ -202,6 +434,20 @@ static const pc_comm_rx_callback sys_conf_callbacks[] =
     [REQ_OUTPUT_CALIB_VALUE] = req_output_calib_value,
     [SET_INPUT_CALIB_VALUE] = set_input_calib_value,
     [SET_OUTPUT_CALIB_VALUE] = set_output_calib_value,
+
+    [REQ_OUTPUT_LUT] = req_output_lut,
+    [SET_OUTPUT_LUT] = set_output_lut,
+
+    [SET_OUTPUT_MAX_ACCEL] = set_output_accel,
+    [REQ_OUTPUT_MAX_ACCEL] = req_output_accel,
+
+    [SET_OUTPUT_MAX_JERK] = set_output_jerk,
+    [REQ_OUTPUT_MAX_JERK] = req_output_jerk,
+
+    [REQ_SYS_CONF_DIGEST] = req_sys_conf_digest,
+
+    [REQ_SYS_CONF_IMAGE] = req_sys_conf_image,
+    [SET_SYS_CONF_IMAGE] = set_sys_conf_image,
 };
 
 static pccom_callbacks comm_sys_conf_callbacks =
@@ -237,6 +483,41 @@ void sys_conf_reset_input_calib()
     }
 }
 
+void load_sys_conf()
+{
+    int i;
+
+    //start from current configuration, missing sections will keep their value
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        memcpy(&conf_buffer, &sys_conf, sizeof(system_conf_t));
+        xSemaphoreGive(sysconf_mutex);
+    }
+
+    build_conf_sections(&conf_buffer, &conf_global);
+
+    //first section is the global one, don't go further if it is not compatible
+    if(!conf_store_load(&conf_sections[0]) ||
+       conf_global.compatibility_magic != CURRENT_COMPATIBILITY_MAGIC)
+    {
+        return;
+    }
+    conf_buffer.servo_active_bm = conf_global.servo_active_bm;
+    conf_buffer.input_nb = MIN(conf_global.input_nb, MAX_IN_NB);
+    conf_buffer.output_nb = MIN(conf_global.output_nb, MAX_SERVO_NB);
+
+    for(i=1; i<CONF_SECTION_NB; i++)
+    {
+        conf_store_load(&conf_sections[i]);
+    }
+
+    if(xSemaphoreTake(sysconf_mutex, portMAX_DELAY))
+    {
+        memcpy(&sys_conf, &conf_buffer, sizeof(system_conf_t));
+        xSemaphoreGive(sysconf_mutex);
+    }
+}
+
 void init_sys_conf()
 {
     int i;
@@ -268,7 +549,10 @@ void init_sys_conf()
         out_conf->name[0] = (char)('A'+i);
         out_conf->name[1] = '\0';
         out_conf->max_speed = 0;
+        out_conf->max_accel = 0;
+        out_conf->max_jerk = 0;
         output_calib_init_default(&out_conf->calib);
+        output_lut_init_default(&out_conf->calib, &sys_conf.out_lut[i]);
     }
 
     sysconf_mutex = xSemaphoreCreateMutex();
@@ -277,6 +561,10 @@ void init_sys_conf()
         FATAL_ERROR();
     }
 
+    //restore last saved configuration
+    conf_store_init();
+    load_sys_conf();
+
     pc_comm_register_module_callback(PCCOM_SYS_CONF, comm_sys_conf_callbacks);
 }
 
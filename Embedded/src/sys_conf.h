@@ -27,18 +27,7 @@
 #define SIZEOF_ARRAY(x) sizeof(x)/sizeof(x[0])
 
 
-typedef struct {
-    input_calib_data_t calib;
-    char name[IO_NAME_LEN];
-    uint8_t mapping;  //logical input => physical input
-} input_conf_t;
-
-typedef struct {
-    output_calib_data_t calib;
-    char name[IO_NAME_LEN];
-    uint8_t max_speed; //maximum speed in SPEED_COEF/2^16 per refresh period
-} output_conf_t;
-
+//input_conf_t and output_conf_t are shared with the PC, see pc_comm_api.h
 
 typedef struct {
     uint32_t compatibility_magic;
@@ -48,6 +37,7 @@ typedef struct {
 
     uint8_t output_nb;
     output_conf_t out_conf[MAX_SERVO_NB];
+    output_lut_t out_lut[MAX_SERVO_NB];
 
     uint32_t servo_active_bm;
 } system_conf_t;
@@ -60,7 +50,8 @@ typedef struct {
 void init_sys_conf();
 
 /**
- * Load configuration from the user flash
+ * Load configuration from the user flash, current values are kept
+ * if no compatible configuration has been saved.
  */
 void load_sys_conf();
 
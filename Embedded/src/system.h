@@ -46,6 +46,14 @@ typedef uint16_t rctime_t;
 #define TC4_TICK_TO_US(time_in_tick) ((TC4_SCALER) * (time_in_tick) / ((APPLI_PBA_SPEED) / 1000000))
 
 
+//! free running 16 bits timer (TC4 clock source) used as system time base
+//! it wraps around every 65536 ticks (~35ms), so only use it for short delays
+#define SYSTEM_TC_CHANNEL         1
+
+//! get current value of the system time base
+#define system_timer_get_value() ((rctime_t)(AVR32_TC.channel[SYSTEM_TC_CHANNEL].cv & 0xFFFF))
+
+
 /**
  * Reset the board into dfu bootloader mode
  */
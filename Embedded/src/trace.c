@@ -24,13 +24,9 @@
 #include "task.h"
 #include "semphr.h"
 
-#include "usb_standard_request.h"
-
 #include "trace.h"
 #include "pc_comm.h"
 
-#include "usb_drv.h"
-
 
 //In debug mode we enable the full-featured snprintf trace function
 #ifdef TRACE_DEBUG
@@ -54,26 +50,6 @@ static xSemaphoreHandle trace_mutex;
 #endif
 
 
-static bool avr32_usb_dev_master_send(const char *buffer, int size)
-{
-    if(!Is_device_enumerated())
-    {
-        return false;
-    }
-    if(!Is_usb_write_enabled(MASTER_TX_EP))
-    {
-        return false;
-    }
-
-    while(size)
-    {
-        Usb_reset_endpoint_fifo_access(MASTER_TX_EP);
-        size = usb_write_ep_txpacket(MASTER_TX_EP, buffer, size, (const void**)&buffer);
-        Usb_ack_in_ready_send(MASTER_TX_EP);
-    }
-    return true;
-}
-
 //In debug mode we enable the full-featured snprintf trace function
 #ifdef TRACE_DEBUG
 
@@ -159,7 +135,7 @@ void trace_task(void *arg)
         uint32_t count = count_data();
         size = MIN(count, (end_ptr - read_ptr));
         size = MIN(size, MAX_PACKET_SIZE);
-        if(size>0 && avr32_usb_dev_master_send(read_ptr, size))
+        if(size>0 && pc_comm_master_send(read_ptr, size, true))
         {
             read_ptr = INC_PTR(trace_buffer, read_ptr, size);
         }
@@ -194,7 +170,7 @@ void trace_init(void)
 void trace(const char *log, ...)
 {
     //push the buffer without formatting
-    avr32_usb_dev_master_send(log, strlen(log));
+    pc_comm_master_send(log, strlen(log), true);
 }
 
 void trace_init(void)
@@ -0,0 +1,311 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//see header for overview and documentation
+
+#include "user_flash.h"
+
+#include "board.h"
+#include "flashc.h"
+
+#include "pc_comm.h"
+#include "sys_conf.h"
+#include "openscb_utils.h"
+
+#include <string.h>
+
+
+#define SLOT_ADDR(no)       (USER_FLASH_ORIG + (no)*USER_FLASH_SLOT_SIZE)
+
+//! header copies written when the description changes
+#define DESC_ADDR(no)       (SLOT_ADDR(no) + USER_FLASH_SLOT_SIZE - USER_FLASH_DESC_SIZE)
+#define DESC_ENTRY_NB       (USER_FLASH_DESC_SIZE / sizeof(slot_header_t))
+
+
+//! copy of valid slot headers, invalid slots are SLOT_UNINIT
+static slot_header_t headers[FLASH_SLOT_NB];
+
+//! next free header copy of each slot, DESC_ENTRY_NB if the page is full
+static uint8_t desc_free[FLASH_SLOT_NB];
+
+
+//! helper function: check the last flash command
+static bool flash_ok(void)
+{
+    return !flashc_is_lock_error() && !flashc_is_programming_error();
+}
+
+//! helper function: compute the crc of a slot
+static uint16_t slot_crc(const slot_header_t *header, const void *data)
+{
+    uint16_t crc = scb_crc16(SCB_CRC16_INIT, &header->type, sizeof(header->type));
+    crc = scb_crc16(crc, header->description, SLOT_DESC_SIZE);
+    crc = scb_crc16(crc, &header->size, sizeof(header->size));
+    return scb_crc16(crc, data, header->size);
+}
+
+//! helper function: set a cached header as uninitialized
+static void header_clear(slot_header_t *header)
+{
+    memset(header, 0, sizeof(slot_header_t));
+    header->type = SLOT_UNINIT;
+}
+
+//! helper function: check a header stored in flash against slot data
+static bool header_is_valid(uint8_t slot, const slot_header_t *header)
+{
+    return header->type != SLOT_UNINIT && header->size <= USER_FLASH_DATA_SIZE &&
+           header->crc == slot_crc(header, user_flash_get_data(slot));
+}
+
+//! helper function: check if a header copy location is erased
+static bool entry_is_erased(const slot_header_t *entry)
+{
+    const uint8_t *p = (const uint8_t *)entry;
+    int i;
+
+    for(i=0; i<sizeof(slot_header_t); i++)
+    {
+        if(p[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! helper function: load the header of a slot in cache, checking its content
+static void header_load(uint8_t slot)
+{
+    const slot_header_t *header = (const slot_header_t *)SLOT_ADDR(slot);
+    const slot_header_t *desc = (const slot_header_t *)DESC_ADDR(slot);
+    int i;
+
+    //copies are appended, the last written one is after all others
+    desc_free[slot] = 0;
+    for(i=0; i<DESC_ENTRY_NB; i++)
+    {
+        if(!entry_is_erased(&desc[i]))
+        {
+            desc_free[slot] = i+1;
+        }
+    }
+
+    if(!header_is_valid(slot, header))
+    {
+        header_clear(&headers[slot]);
+        return;
+    }
+
+    //latest valid copy describing the same data, an interrupted one is skipped
+    for(i=desc_free[slot]-1; i>=0; i--)
+    {
+        if(desc[i].type == header->type && desc[i].size == header->size &&
+           header_is_valid(slot, &desc[i]))
+        {
+            header = &desc[i];
+            break;
+        }
+    }
+    memcpy(&headers[slot], header, sizeof(slot_header_t));
+}
+
+
+// see header for documentation
+const slot_header_t *user_flash_get_header(uint8_t slot)
+{
+    if(slot >= FLASH_SLOT_NB)
+    {
+        return NULL;
+    }
+    return &headers[slot];
+}
+
+
+// see header for documentation
+const void *user_flash_get_data(uint8_t slot)
+{
+    if(slot >= FLASH_SLOT_NB)
+    {
+        return NULL;
+    }
+    return (const void *)(SLOT_ADDR(slot) + sizeof(slot_header_t));
+}
+
+
+// see header for documentation
+bool user_flash_erase(uint8_t slot)
+{
+    int page = (SLOT_ADDR(slot) - AVR32_FLASH_ADDRESS) / AVR32_FLASHC_PAGE_SIZE;
+    int i;
+
+    if(slot >= FLASH_SLOT_NB)
+    {
+        return false;
+    }
+
+    header_clear(&headers[slot]);
+    desc_free[slot] = 0;
+
+    for(i=0; i<USER_FLASH_SLOT_SIZE/AVR32_FLASHC_PAGE_SIZE; i++)
+    {
+        if(!flashc_erase_page(page+i, TRUE))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// see header for documentation
+bool user_flash_write_data(uint8_t slot, uint32_t offset, const void *data, uint32_t size)
+{
+    if(slot >= FLASH_SLOT_NB || offset + size > USER_FLASH_DATA_SIZE)
+    {
+        return false;
+    }
+
+    //slot is already erased, only touched pages are programmed
+    flashc_memcpy((void*)(SLOT_ADDR(slot) + sizeof(slot_header_t) + offset), data, size, FALSE);
+    return flash_ok();
+}
+
+
+// see header for documentation
+bool user_flash_write_header(uint8_t slot, uint32_t type, const char *desc, uint32_t size)
+{
+    slot_header_t header;
+
+    if(slot >= FLASH_SLOT_NB || size > USER_FLASH_DATA_SIZE)
+    {
+        return false;
+    }
+
+    header.type = type;
+    memset(header.description, 0, SLOT_DESC_SIZE);
+    strncpy(header.description, desc, SLOT_DESC_SIZE-1);
+    header.size = size;
+    header.crc = slot_crc(&header, user_flash_get_data(slot));
+
+    flashc_memcpy((void*)SLOT_ADDR(slot), &header, sizeof(header), FALSE);
+    header_load(slot);
+    return flash_ok();
+}
+
+
+// see header for documentation
+bool user_flash_set_description(uint8_t slot, const char *desc)
+{
+    slot_header_t header;
+    slot_header_t *entry;
+
+    if(slot >= FLASH_SLOT_NB || headers[slot].type == SLOT_UNINIT)
+    {
+        return false;
+    }
+
+    //only the description page is erased, data and first header are kept
+    if(desc_free[slot] >= DESC_ENTRY_NB)
+    {
+        int page = (DESC_ADDR(slot) - AVR32_FLASH_ADDRESS) / AVR32_FLASHC_PAGE_SIZE;
+        if(!flashc_erase_page(page, TRUE))
+        {
+            return false;
+        }
+        desc_free[slot] = 0;
+    }
+
+    memcpy(&header, &headers[slot], sizeof(header));
+    memset(header.description, 0, SLOT_DESC_SIZE);
+    strncpy(header.description, desc, SLOT_DESC_SIZE-1);
+    header.crc = slot_crc(&header, user_flash_get_data(slot));
+
+    entry = (slot_header_t *)DESC_ADDR(slot) + desc_free[slot];
+    flashc_memcpy(entry, &header, sizeof(header), FALSE);
+    header_load(slot);
+    return flash_ok();
+}
+
+
+
+
+/*------------------------API----------------------------*/
+
+
+
+
+static void req_overview(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    uint8_t slot = header->index;
+
+    if(slot < FLASH_SLOT_NB)
+    {
+        pc_comm_send_packet(header->module, header->command, slot,
+                &headers[slot], sizeof(slot_header_t));
+    }
+}
+
+static void req_overview_all(pccomm_packet_t *packet)
+{
+    pccomm_msg_header_t *header = &packet->header;
+    pc_comm_send_array(header->module, header->command, headers,
+            sizeof(slot_header_t), FLASH_SLOT_NB);
+}
+
+static void set_description(pccomm_packet_t *packet)
+{
+    char desc[SLOT_DESC_SIZE];
+    int len = packet->header.size - sizeof(pccomm_msg_header_t);
+
+    len = MAX(MIN(len, SLOT_DESC_SIZE-1), 0);
+    memcpy(desc, packet->data, len);
+    desc[len] = '\0';
+
+    user_flash_set_description(packet->header.index, desc);
+}
+
+static const pc_comm_rx_callback rx_callbacks[] =
+{
+    [FLASH_REQ_OVERVIEW] = req_overview,
+    [FLASH_REQ_OVERVIEW_ALL] = req_overview_all,
+
+    [FLASH_SET_DESCRIPTION] = set_description,
+};
+
+static pccom_callbacks comm_callbacks =
+{
+    .callback_nb = SIZEOF_ARRAY(rx_callbacks),
+    .callbacks = rx_callbacks
+};
+
+
+// see header for documentation
+void user_flash_init(void)
+{
+    int i;
+
+    //slots are checked once, then only the cached headers are used
+    for(i=0; i<FLASH_SLOT_NB; i++)
+    {
+        header_load(i);
+    }
+
+    pc_comm_register_module_callback(PCCOM_USER_FLASH, comm_callbacks);
+}
@@ -0,0 +1,99 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file user_flash.h
+ * \brief User flash slots
+ *
+ * FLASH_SLOT_NB slots of USER_FLASH_SLOT_SIZE bytes are reserved in flash to
+ * store user data (sequences, ...). Each slot starts with a slot_header_t
+ * followed by its data. The header is written last, so a slot whose write
+ * has been interrupted stays uninitialized.
+ * The last USER_FLASH_DESC_SIZE bytes of a slot are a separate flash page where
+ * a copy of the header is appended each time the description changes, so
+ * renaming a slot never erases its data. The latest valid copy is used.
+ * Headers are checked (CRC of header and data) once at startup and kept in
+ * RAM, slots with an invalid header are reported as SLOT_UNINIT.
+ */
+
+#ifndef USER_FLASH_H_
+#define USER_FLASH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pc_comm_api.h"
+
+
+//! size of data that can be stored in one slot
+#define USER_FLASH_DATA_SIZE    (USER_FLASH_SLOT_SIZE - USER_FLASH_DESC_SIZE - sizeof(slot_header_t))
+
+
+/**
+ * Check all slots and register PCCOM_USER_FLASH module.
+ */
+void user_flash_init(void);
+
+/**
+ * Get the header of a slot (from cache, no flash access).
+ *
+ * \return NULL if slot does not exist
+ */
+const slot_header_t *user_flash_get_header(uint8_t slot);
+
+/**
+ * Get the data of a slot, data can be read directly from flash.
+ *
+ * \return NULL if slot does not exist
+ */
+const void *user_flash_get_data(uint8_t slot);
+
+/**
+ * Erase a whole slot (header and data), this takes some time.
+ *
+ * \return false on flash error or if slot does not exist
+ */
+bool user_flash_erase(uint8_t slot);
+
+/**
+ * Write data in an erased slot.
+ *
+ * \param offset offset from the beginning of slot data
+ * \return false on flash error or if data does not fit in the slot
+ */
+bool user_flash_write_data(uint8_t slot, uint32_t offset, const void *data, uint32_t size);
+
+/**
+ * Write the header of an erased slot, this should be done once all data are written.
+ *
+ * \param desc description of the slot content, truncated to SLOT_DESC_SIZE-1
+ * \param size size of data in the slot
+ * \return false on flash error or if slot does not exist
+ */
+bool user_flash_write_header(uint8_t slot, uint32_t type, const char *desc, uint32_t size);
+
+/**
+ * Change the description of a valid slot, slot data is not touched and can be
+ * read meanwhile. When the description page is full, it is erased first and
+ * the description written with data is reported until the new one is written.
+ *
+ * \return false on flash error or if slot is not initialized
+ */
+bool user_flash_set_description(uint8_t slot, const char *desc);
+
+#endif /* USER_FLASH_H_ */
@@ -0,0 +1,146 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host benchmark of sequence evaluation: execute_sequence scans the points
+ * from the start at each call, execute_sequence_cursor starts from the last
+ * segment. Both are run on the same 1000 points sequences with time moving
+ * forward by small steps, like a sequence played by the core task, then
+ * with random times. Results of both functions are compared.
+ *
+ * Build and run from this directory with: make run
+ */
+
+#include "rc_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+#define POINT_NB        1000
+#define SEQUENCE_NB     20
+//time step between two evaluations, ~14 ms for a 30 s sequence
+#define TIME_STEP       15
+//random times evaluated per sequence, time going back or jumping ahead
+#define RANDOM_NB       2000
+
+
+static sequence_point_t pts[POINT_NB + 1];
+
+
+//! helper function: build a random sequence, times are spread over [0..1]
+static void build_sequence(void)
+{
+    sequence_point_t end = END_OF_SEQ;
+    int i;
+
+    for(i=0; i<POINT_NB; i++)
+    {
+        pts[i].t = i * (DSP16_MAX / POINT_NB);
+        pts[i].y = (rand() % 0x10000) - 0x8000;
+    }
+    pts[POINT_NB] = end;
+}
+
+//! helper function: elapsed time since start in ms
+static double elapsed_ms(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000. + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+
+int main(void)
+{
+    static rc_value_t ref[DSP16_MAX + 1];
+    dsp16_t last_t = (POINT_NB - 1) * (DSP16_MAX / POINT_NB);
+    double scan_ms = 0, cursor_ms = 0, random_scan_ms = 0, random_cursor_ms = 0;
+    static dsp16_t random_t[RANDOM_NB];
+    long eval_nb = 0, mismatch_nb = 0;
+    volatile rc_value_t sink;
+    struct timespec start;
+    int s, dt;
+
+    srand(1);
+    for(s=0; s<SEQUENCE_NB; s++)
+    {
+        sequence_cursor_t cursor;
+        rc_value_t amp = DSP16_MAX - s;
+        int n = 0;
+
+        build_sequence();
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(dt=0; dt<=last_t; dt+=TIME_STEP)
+        {
+            ref[n++] = execute_sequence(pts, dt, amp);
+        }
+        scan_ms += elapsed_ms(&start);
+
+        sequence_cursor_init(&cursor, pts);
+        n = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(dt=0; dt<=last_t; dt+=TIME_STEP)
+        {
+            sink = execute_sequence_cursor(&cursor, dt, amp);
+            if(sink != ref[n++])
+            {
+                mismatch_nb++;
+            }
+        }
+        cursor_ms += elapsed_ms(&start);
+        eval_nb += n;
+
+        for(n=0; n<RANDOM_NB; n++)
+        {
+            random_t[n] = rand() % (last_t + 1);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(n=0; n<RANDOM_NB; n++)
+        {
+            ref[n] = execute_sequence(pts, random_t[n], amp);
+        }
+        random_scan_ms += elapsed_ms(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(n=0; n<RANDOM_NB; n++)
+        {
+            sink = execute_sequence_cursor(&cursor, random_t[n], amp);
+            if(sink != ref[n])
+            {
+                mismatch_nb++;
+            }
+        }
+        random_cursor_ms += elapsed_ms(&start);
+    }
+
+    printf("%d sequences of %d points\n", SEQUENCE_NB, POINT_NB);
+    printf("forward, %ld evaluations:\n", eval_nb);
+    printf("  execute_sequence:        %8.2f ms\n", scan_ms);
+    printf("  execute_sequence_cursor: %8.2f ms\n", cursor_ms);
+    printf("random, %d evaluations:\n", SEQUENCE_NB * RANDOM_NB);
+    printf("  execute_sequence:        %8.2f ms\n", random_scan_ms);
+    printf("  execute_sequence_cursor: %8.2f ms\n", random_cursor_ms);
+    printf("mismatches:                %8ld\n", mismatch_nb);
+
+    return (mismatch_nb == 0) ? 0 : 1;
+}
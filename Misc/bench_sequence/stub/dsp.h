@@ -0,0 +1,99 @@
+/*
+ *  This file is part of OpenSCB project <http://openscb.org>.
+ *  Copyright (C) 2010  Opendrain
+ *
+ *  OpenSCB software is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  OpenSCB software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with OpenSCB software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host stand-in for the AVR32 dsplib, only what rc_utils.c uses.
+ * Fixed point formats and rounding follow the dsplib reference C code.
+ */
+
+#ifndef DSP_H_
+#define DSP_H_
+
+#include <stdint.h>
+#include <math.h>
+
+//DSP16_MIN and DSP16_MAX are shared with the API
+#include "pc_comm_api.h"
+
+typedef int16_t dsp16_t;
+typedef int32_t dsp32_t;
+
+#define DSP16_QA            1
+#define DSP16_QB            15
+
+#define DSP16_Q(x)          ((dsp16_t)((x) * (1 << DSP16_QB)))
+#define DSP_Q_MAX(a, b)     ((1 << ((a) + (b) - 1)) - 1)
+#define DSP_Q_MIN(a, b)     (-(1 << ((a) + (b) - 1)))
+
+#define A_ALIGNED           __attribute__((aligned(4)))
+
+static inline dsp16_t dsp16_op_mul(dsp16_t a, dsp16_t b)
+{
+    return (dsp16_t)(((dsp32_t)a * b) >> DSP16_QB);
+}
+
+static inline dsp16_t dsp16_op_div(dsp16_t a, dsp16_t b)
+{
+    return (dsp16_t)(((dsp32_t)a << DSP16_QB) / b);
+}
+
+static inline dsp16_t dsp16_op_abs(dsp16_t a)
+{
+    return (a < 0) ? -a : a;
+}
+
+//angles are in [-1..1] for [-pi..pi]
+static inline dsp16_t dsp16_op_sin(dsp16_t a)
+{
+    return (dsp16_t)(sin(a * M_PI / 32768.) * DSP16_MAX);
+}
+
+static inline dsp16_t dsp16_op_cos(dsp16_t a)
+{
+    return (dsp16_t)(cos(a * M_PI / 32768.) * DSP16_MAX);
+}
+
+static inline void dsp16_vect_add(dsp16_t *res, dsp16_t *a, dsp16_t *b, int size)
+{
+    int i;
+    for(i=0; i<size; i++)
+        res[i] = a[i] + b[i];
+}
+
+static inline void dsp16_vect_dotmul(dsp16_t *res, dsp16_t *a, dsp16_t *b, int size)
+{
+    int i;
+    for(i=0; i<size; i++)
+        res[i] = dsp16_op_mul(a[i], b[i]);
+}
+
+static inline void dsp16_vect_dotdiv(dsp16_t *res, dsp16_t *a, dsp16_t *b, int size)
+{
+    int i;
+    for(i=0; i<size; i++)
+        res[i] = dsp16_op_div(a[i], b[i]);
+}
+
+static inline void dsp16_vect_intmul(dsp16_t *res, dsp16_t *a, int size, int k)
+{
+    int i;
+    for(i=0; i<size; i++)
+        res[i] = a[i] * k;
+}
+
+#endif /* DSP_H_ */